@@ -64,6 +64,20 @@ template <typename Traits> struct CellListOrdered_params {
 
 template <typename Traits> struct CellListOrderedQuery;
 
+///
+/// @brief the order in which the buckets of a @ref CellListOrdered are
+/// numbered. Since particles are sorted by bucket, this also sets the order of
+/// the particles in memory
+///
+enum class cell_ordering {
+  /// buckets are numbered in row-major order (the default)
+  row_major,
+  /// buckets are numbered along a Morton (Z-order) curve
+  morton,
+  /// buckets are numbered along a Hilbert curve
+  hilbert
+};
+
 /// @brief A cell list spatial data structure that is paired with a
 /// CellListOrderedQuery query type
 ///
@@ -77,6 +91,12 @@ template <typename Traits> struct CellListOrderedQuery;
 /// if you are often looping over neighbouring particles. It also mean that
 /// particles within a given bucket are sequential in memory.
 ///
+/// By default the buckets are numbered in row-major order, so neighbouring
+/// buckets along the slowest varying dimension are far apart in memory. Use
+/// set_cell_ordering() to number the buckets along a Morton or Hilbert
+/// space-filling curve instead, so that neighbouring buckets (and therefore
+/// neighbouring particles) are mostly close in memory.
+///
 ///
 template <typename Traits>
 class CellListOrdered
@@ -103,10 +123,28 @@ class CellListOrdered
 public:
   CellListOrdered()
       : base_type(),
-        m_size_calculated_with_n(std::numeric_limits<size_t>::max()) {}
+        m_size_calculated_with_n(std::numeric_limits<size_t>::max()),
+        m_cell_ordering(cell_ordering::row_major) {}
 
   static constexpr bool ordered() { return true; }
 
+  ///
+  /// @brief set the order in which the buckets are numbered, and therefore
+  /// the order of the particles in memory.
+  ///
+  /// This takes effect the next time the domain is set, so should be called
+  /// before Particles::init_neighbour_search()
+  ///
+  void set_cell_ordering(const cell_ordering ordering) {
+    m_cell_ordering = ordering;
+    m_size_calculated_with_n = std::numeric_limits<size_t>::max();
+  }
+
+  ///
+  /// @brief returns the order in which the buckets are numbered
+  ///
+  cell_ordering get_cell_ordering() const { return m_cell_ordering; }
+
   struct delete_points_lambda;
 
   void print_data_structure() const {
@@ -155,9 +193,17 @@ private:
       }
       m_bucket_side_length =
           (this->m_bounds.bmax - this->m_bounds.bmin) / m_size;
+      if (m_cell_ordering == cell_ordering::row_major) {
+        m_bucket_index_map.clear();
+      } else {
+        calculate_bucket_index_map();
+      }
       m_point_to_bucket_index =
           detail::point_to_bucket_index<Traits::dimension>(
-              m_size, m_bucket_side_length, this->m_bounds);
+              m_size, m_bucket_side_length, this->m_bounds,
+              m_bucket_index_map.empty()
+                  ? nullptr
+                  : iterator_to_raw_pointer(m_bucket_index_map.begin()));
 
       LOG(2, "\tbucket side length = " << m_bucket_side_length);
       LOG(2, "\tnumber of buckets = " << m_size << " (total=" << m_size.prod()
@@ -185,6 +231,44 @@ private:
     }
   }
 
+  ///
+  /// @brief number the buckets along a space-filling curve. Each bucket's
+  /// position along the curve (on the enclosing power-of-two lattice) is
+  /// calculated, then the buckets are sorted by this key and numbered
+  /// contiguously
+  ///
+  void calculate_bucket_index_map() {
+    const unsigned int n = m_size.prod();
+    unsigned int bits = 1;
+    while ((1u << bits) < m_size.maxCoeff()) {
+      ++bits;
+    }
+    CHECK(bits * Traits::dimension <= 64,
+          "CellListOrdered: too many buckets for space-filling curve ordering");
+
+    const detail::bucket_index<Traits::dimension> row_major(m_size);
+    std::vector<uint64_t> keys(n);
+    std::vector<unsigned int> buckets(n);
+    for (unsigned int i = 0; i < n; ++i) {
+      const unsigned_int_d bucket = row_major.reassemble_index_vector(i);
+      keys[i] = m_cell_ordering == cell_ordering::morton
+                    ? detail::morton_key(bucket, bits)
+                    : detail::hilbert_key(bucket, bits);
+      buckets[i] = i;
+    }
+    detail::sort_by_key(keys.begin(), keys.end(), buckets.begin());
+
+    std::vector<unsigned int> index_map(n);
+    for (unsigned int i = 0; i < n; ++i) {
+      index_map[buckets[i]] = i;
+    }
+    m_bucket_index_map = vector_unsigned_int(index_map.begin(), index_map.end());
+    LOG(2, "	numbered buckets along a "
+               << (m_cell_ordering == cell_ordering::morton ? "Morton"
+                                                            : "Hilbert")
+               << " curve");
+  }
+
   void update_iterator_impl() {}
 
   void update_positions_impl(iterator update_begin, iterator update_end,
@@ -269,11 +353,14 @@ private:
   vector_unsigned_int m_bucket_begin;
   vector_unsigned_int m_bucket_end;
   vector_unsigned_int m_bucket_indices;
+  // optional map from row-major bucket index to the bucket number used
+  vector_unsigned_int m_bucket_index_map;
   CellListOrderedQuery<Traits> m_query;
 
   double_d m_bucket_side_length;
   unsigned_int_d m_size;
   size_t m_size_calculated_with_n;
+  cell_ordering m_cell_ordering;
   detail::point_to_bucket_index<Traits::dimension> m_point_to_bucket_index;
 };
 
@@ -181,8 +181,10 @@ public:
     // overwrite id, alive and random generator
     reference i = *(end() - 1);
     Aboria::get<id>(i) = this->m_next_id++;
+#ifndef ABORIA_COUNTER_BASED_RNG
     Aboria::get<generator>(i) =
         generator_type((m_seed + uint32_t(Aboria::get<id>(i))));
+#endif
     Aboria::get<alive>(i) = true;
 
     push_connections(end() - 1, end());
@@ -192,8 +194,10 @@ public:
   /// for each particle is set to \p value plus the particle's id
   void set_seed(const uint32_t value) {
     m_seed = value;
+#ifndef ABORIA_COUNTER_BASED_RNG
     detail::for_each(begin(), end(),
                      detail::set_seed_lambda<raw_reference>(m_seed));
+#endif
   }
 
   /// returns a reference to the element at index \p idx
@@ -91,6 +91,11 @@ void evaluate_nonlinear(ExprRHS const &expr, LabelType &label) {
     }
   }
 
+#ifdef ABORIA_COUNTER_BASED_RNG
+  // subsequent assignments draw new random numbers
+  particles.advance_random_step();
+#endif
+
   if (boost::is_same<VariableType, position>::value) {
     particles.update_positions();
   }
@@ -148,12 +148,17 @@ private:
       detail::copy(this->m_alive_indices.begin(), this->m_alive_indices.end(),
                    m_particle_indicies.begin() + i * num_points);
 
-      // sort indicies by position in dimension i
+      // sort indicies by position in dimension i, breaking ties by index so
+      // that the order (and hence the tree) does not depend on the sort
+      // algorithm or number of threads used
       detail::sort(
           m_particle_indicies.begin() + i * num_points,
           m_particle_indicies.begin() + (i + 1) * num_points,
           [_p = iterator_to_raw_pointer(get<position>(this->m_particles_begin)),
-           _i = i](const int a, const int b) { return _p[a][_i] < _p[b][_i]; });
+           _i = i](const int a, const int b) {
+            return _p[a][_i] < _p[b][_i] ||
+                   (_p[a][_i] == _p[b][_i] && a < b);
+          });
     }
     /*
     for (size_t i = 0; i < dimension; ++i) {
@@ -209,6 +214,11 @@ private:
 
     vector_int particle_indicies2(m_particle_indicies.size());
 
+    // scratch space for partitioning particles, reused for every level
+    vector_int e(m_particle_node.size());
+    vector_int f(m_particle_node.size());
+    vector_int addr(m_particle_node.size());
+
     // setup tree
     m_nodes_child.resize(1);
     m_nodes_split_pos.resize(1);
@@ -332,9 +342,6 @@ private:
       //(Sengupta, S., Harris, M., Zhang, Y., & Owens, J. D. (2007). Scan
       // primitives for GPU computing. Graphics …, 97–106.
       // http://doi.org/10.2312/EGGH/EGGH07/097-106)
-      vector_int e(m_particle_node.size());
-      vector_int f(m_particle_node.size());
-      vector_int addr(m_particle_node.size());
 
       // [t f t f f t f] #in
       // [0 1 0 1 1 0 1] #e = set 1 in false elts.
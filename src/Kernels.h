@@ -36,6 +36,7 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef KERNELS_H_
 #define KERNELS_H_
 
+#include <algorithm>
 #include <type_traits>
 
 #include "Particles.h"
@@ -121,6 +122,24 @@ public:
     Triplet::TRIPLET_ASSEMBLE_NOT_IMPLEMENTED;
   }
 
+  /// Adds the number of non-zeros in each row of the kernel to \p counts,
+  /// which points to the count for the first row
+  template <typename StorageIndex>
+  void count_nonzeros(StorageIndex *counts) const {
+    StorageIndex::COUNT_NONZEROS_NOT_IMPLEMENTED;
+  }
+
+  /// Writes the non-zeros of each row of the kernel into the inner index and
+  /// value arrays of a compressed row-major matrix. \p cursor points to
+  /// the next free position for the first row, and each row's cursor is
+  /// advanced past the entries written. Column indices are offset by \p
+  /// startJ and are written in increasing order
+  template <typename StorageIndex>
+  void assemble_rows(StorageIndex *cursor, StorageIndex *inner, Scalar *values,
+                     const size_t startJ = 0) const {
+    StorageIndex::ASSEMBLE_ROWS_NOT_IMPLEMENTED;
+  }
+
   /// Evaluates a matrix-free linear operator given by \p expr \p if_expr,
   /// and particle sets \p a and \p b on a vector rhs and
   /// accumulates the result in vector lhs
@@ -170,16 +189,23 @@ public:
     ASSERT(matrix.cols() == static_cast<typename Derived::Index>(this->cols()),
            "matrix has incompatible col size");
 
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
     for (size_t i = 0; i < na; ++i) {
+      const_row_reference ai = a[i];
       for (size_t j = 0; j < nb; ++j) {
         const_cast<Eigen::DenseBase<Derived> &>(matrix)
             .template block<BlockRows, BlockCols>(i * BlockRows,
                                                   j * BlockCols) =
-            Block(this->m_function(a[i], b[j]));
+            Block(this->m_function(ai, b[j]));
       }
     }
   }
 
+  /// Appends the non-zeros of the kernel to \p triplets, offset by \p
+  /// startI and \p startJ. The triplet vector is resized once and each
+  /// row of the kernel is written in parallel to its own range
   template <typename Triplet>
   void assemble(std::vector<Triplet> &triplets, const size_t startI = 0,
                 const size_t startJ = 0) const {
@@ -190,16 +216,60 @@ public:
     const size_t na = a.size();
     const size_t nb = b.size();
 
+    const size_t start = triplets.size();
+    const size_t block_size = BlockRows * BlockCols;
+    triplets.resize(start + na * nb * block_size);
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
     for (size_t i = 0; i < na; ++i) {
       const_row_reference ai = a[i];
+      size_t k = start + i * nb * block_size;
       for (size_t j = 0; j < nb; ++j) {
-        const_col_reference bj = b[j];
-        const Block element = static_cast<Block>(this->m_function(ai, bj));
+        const Block element = static_cast<Block>(this->m_function(ai, b[j]));
+        for (size_t ii = 0; ii < BlockRows; ++ii) {
+          for (size_t jj = 0; jj < BlockCols; ++jj, ++k) {
+            triplets[k] =
+                Triplet(i * BlockRows + ii + startI,
+                        j * BlockCols + jj + startJ, element(ii, jj));
+          }
+        }
+      }
+    }
+  }
+
+  template <typename StorageIndex>
+  void count_nonzeros(StorageIndex *counts) const {
+    const size_t n = this->rows();
+    const size_t nnz_per_row = this->cols();
+    for (size_t i = 0; i < n; ++i) {
+      counts[i] += nnz_per_row;
+    }
+  }
+
+  template <typename StorageIndex>
+  void assemble_rows(StorageIndex *cursor, StorageIndex *inner, Scalar *values,
+                     const size_t startJ = 0) const {
+
+    const RowElements &a = this->m_row_elements;
+    const ColElements &b = this->m_col_elements;
+
+    const size_t na = a.size();
+    const size_t nb = b.size();
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < na; ++i) {
+      const_row_reference ai = a[i];
+      for (size_t j = 0; j < nb; ++j) {
+        const Block element = static_cast<Block>(this->m_function(ai, b[j]));
         for (size_t ii = 0; ii < BlockRows; ++ii) {
-          for (size_t jj = 0; jj < BlockCols; ++jj) {
-            triplets.push_back(Triplet(i * BlockRows + ii + startI,
-                                       j * BlockCols + jj + startJ,
-                                       element(ii, jj)));
+          StorageIndex &k = cursor[i * BlockRows + ii];
+          for (size_t jj = 0; jj < BlockCols; ++jj, ++k) {
+            inner[k] = j * BlockCols + jj + startJ;
+            values[k] = element(ii, jj);
           }
         }
       }
@@ -208,7 +278,17 @@ public:
 
   /// Evaluates a matrix-free linear operator given by \p expr \p if_expr,
   /// and particle sets \p a and \p b on a vector rhs and
-  /// accumulates the result in vector lhs
+  /// accumulates the result in vector lhs. If \p rhs and \p lhs have more
+  /// than one column, the kernel function is evaluated once for each
+  /// particle pair and applied to all the columns
+  ///
+  /// The particle pairs are visited in tiles of tile_rows x tile_cols, so
+  /// that the column particles and rhs entries of a tile stay in cache while
+  /// they are reused by each row, and each row of a tile is accumulated
+  /// locally before being added to lhs. If the kernel only depends on the
+  /// particle positions then the column positions are first copied to a
+  /// structure-of-arrays layout, so that the innermost loop can be
+  /// vectorised by the compiler
   template <typename DerivedLHS, typename DerivedRHS>
   void evaluate(Eigen::DenseBase<DerivedLHS> &lhs,
                 const Eigen::DenseBase<DerivedRHS> &rhs) const {
@@ -219,21 +299,26 @@ public:
     const size_t na = a.size();
     const size_t nb = b.size();
 
-    CHECK(static_cast<size_t>(lhs.size()) == this->rows(),
+    CHECK(static_cast<size_t>(lhs.rows()) == this->rows(),
           "lhs size is inconsistent");
-    CHECK(static_cast<size_t>(rhs.size()) == this->cols(),
+    CHECK(static_cast<size_t>(rhs.rows()) == this->cols(),
           "rhs size is inconsistent");
+    CHECK(lhs.cols() == rhs.cols(), "lhs and rhs have different columns");
 
+    const std::vector<double> col_positions =
+        pack_col_positions(detail::is_position_kernel<F>());
+
+    const size_t n_row_tiles = (na + tile_rows - 1) / tile_rows;
 #ifdef HAVE_OPENMP
 #pragma omp parallel for
 #endif
-    for (size_t i = 0; i < na; ++i) {
-      const_row_reference ai = a[i];
-      for (size_t j = 0; j < nb; ++j) {
-        const_col_reference bj = b[j];
-        lhs.template segment<BlockRows>(i * BlockRows) +=
-            this->m_function(ai, bj) *
-            rhs.template segment<BlockCols>(j * BlockCols);
+    for (size_t ti = 0; ti < n_row_tiles; ++ti) {
+      const size_t i_begin = ti * tile_rows;
+      const size_t i_end = std::min(na, i_begin + tile_rows);
+      for (size_t j_begin = 0; j_begin < nb; j_begin += tile_cols) {
+        const size_t j_end = std::min(nb, j_begin + tile_cols);
+        evaluate_tile(lhs.derived(), rhs.derived(), i_begin, i_end, j_begin,
+                      j_end, col_positions, detail::is_position_kernel<F>());
       }
     }
   }
@@ -265,6 +350,96 @@ public:
       }
     }
   }
+
+private:
+  static const size_t tile_rows = 64;
+  static const size_t tile_cols = 512;
+
+  std::vector<double> pack_col_positions(std::false_type) const {
+    return std::vector<double>();
+  }
+
+  // copies the column positions to a structure-of-arrays layout, with
+  // dimension d of particle j stored at [d * nb + j]
+  std::vector<double> pack_col_positions(std::true_type) const {
+    const ColElements &b = this->m_col_elements;
+    const size_t nb = b.size();
+    std::vector<double> col_positions(dimension * nb);
+    for (size_t j = 0; j < nb; ++j) {
+      const double_d &pj = get<position>(b)[j];
+      for (size_t d = 0; d < dimension; ++d) {
+        col_positions[d * nb + j] = pj[d];
+      }
+    }
+    return col_positions;
+  }
+
+  template <typename DerivedLHS, typename DerivedRHS>
+  void evaluate_tile(DerivedLHS &lhs, const DerivedRHS &rhs,
+                     const size_t i_begin, const size_t i_end,
+                     const size_t j_begin, const size_t j_end,
+                     const std::vector<double> &col_positions,
+                     std::false_type) const {
+    typedef Eigen::Matrix<Scalar, BlockRows, DerivedRHS::ColsAtCompileTime>
+        accumulator_type;
+    const RowElements &a = this->m_row_elements;
+    const ColElements &b = this->m_col_elements;
+    for (size_t i = i_begin; i < i_end; ++i) {
+      const_row_reference ai = a[i];
+      accumulator_type sum = accumulator_type::Zero(BlockRows, rhs.cols());
+      for (size_t j = j_begin; j < j_end; ++j) {
+        sum.noalias() += Block(this->m_function(ai, b[j])) *
+                         rhs.template middleRows<BlockCols>(j * BlockCols);
+      }
+      lhs.template middleRows<BlockRows>(i * BlockRows) += sum;
+    }
+  }
+
+  template <typename DerivedLHS, typename DerivedRHS>
+  void evaluate_tile(DerivedLHS &lhs, const DerivedRHS &rhs,
+                     const size_t i_begin, const size_t i_end,
+                     const size_t j_begin, const size_t j_end,
+                     const std::vector<double> &col_positions,
+                     std::true_type) const {
+    typedef Eigen::Matrix<Scalar, BlockRows, DerivedRHS::ColsAtCompileTime>
+        accumulator_type;
+    const RowElements &a = this->m_row_elements;
+    const size_t nb = this->m_col_elements.size();
+    const double *const pb = col_positions.data();
+    const bool scalar_vector =
+        BlockRows == 1 && BlockCols == 1 && rhs.cols() == 1;
+
+    for (size_t i = i_begin; i < i_end; ++i) {
+      const double_d &pi = get<position>(a)[i];
+      if (scalar_vector) {
+        // scalar kernel and a single rhs vector: reduce into a plain
+        // scalar so that the loop over j can be vectorised
+        Scalar sum = 0;
+#ifdef HAVE_OPENMP
+#pragma omp simd reduction(+ : sum)
+#endif
+        for (size_t j = j_begin; j < j_end; ++j) {
+          double_d pj;
+          for (size_t d = 0; d < dimension; ++d) {
+            pj[d] = pb[d * nb + j];
+          }
+          sum += Block(this->m_function.m_f(pi, pj))(0, 0) * rhs.coeff(j, 0);
+        }
+        lhs.coeffRef(i, 0) += sum;
+      } else {
+        accumulator_type sum = accumulator_type::Zero(BlockRows, rhs.cols());
+        for (size_t j = j_begin; j < j_end; ++j) {
+          double_d pj;
+          for (size_t d = 0; d < dimension; ++d) {
+            pj[d] = pb[d * nb + j];
+          }
+          sum.noalias() += Block(this->m_function.m_f(pi, pj)) *
+                           rhs.template middleRows<BlockCols>(j * BlockCols);
+        }
+        lhs.template middleRows<BlockRows>(i * BlockRows) += sum;
+      }
+    }
+  }
 };
 
 template <typename RowElements, typename ColElements, typename F>
@@ -298,6 +473,9 @@ public:
     const ColElements &b = this->m_col_elements;
 
     m_matrix.resize(this->rows(), this->cols());
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
     for (size_t i = 0; i < a.size(); ++i) {
       const_row_reference ai = a[i];
       for (size_t j = 0; j < b.size(); ++j) {
@@ -349,9 +527,11 @@ public:
   template <typename DerivedLHS, typename DerivedRHS>
   void evaluate(Eigen::DenseBase<DerivedLHS> &lhs,
                 const Eigen::DenseBase<DerivedRHS> &rhs) const {
-    ASSERT(lhs.size() == this->rows(), "lhs size not consistent")
-    ASSERT(rhs.size() == this->cols(), "lhs size not consistent")
-    lhs += m_matrix * rhs;
+    ASSERT(static_cast<size_t>(lhs.rows()) == this->rows(),
+           "lhs size not consistent")
+    ASSERT(static_cast<size_t>(rhs.rows()) == this->cols(),
+           "rhs size not consistent")
+    lhs.derived() += m_matrix * rhs.derived();
   }
 };
 
@@ -378,8 +558,8 @@ class KernelChebyshev : public KernelDense<RowElements, ColElements, F> {
   const int_d m_start;
   const int_d m_end;
   PositionF m_position_function;
-  mutable vector_type m_W;
-  mutable vector_type m_fcheb;
+  mutable matrix_type m_W;
+  mutable matrix_type m_fcheb;
 
 public:
   typedef typename base_type::Scalar Scalar;
@@ -399,8 +579,8 @@ public:
   void set_n(const unsigned int n) {
     m_order = n;
     m_ncheb = std::pow(n, dimension);
-    m_W.resize(m_ncheb * BlockCols);
-    m_fcheb.resize(m_ncheb * BlockRows);
+    m_W.resize(m_ncheb * BlockCols, 1);
+    m_fcheb.resize(m_ncheb * BlockRows, 1);
 
     update_row_positions();
     update_col_positions();
@@ -456,7 +636,8 @@ public:
 
   /// Evaluates a matrix-free linear operator given by \p expr \p if_expr,
   /// and particle sets \p a and \p b on a vector rhs and
-  /// accumulates the result in vector lhs
+  /// accumulates the result in vector lhs. Multiple columns in \p rhs are
+  /// interpolated together using matrix-matrix products
   template <typename DerivedLHS, typename DerivedRHS>
   void evaluate(Eigen::DenseBase<DerivedLHS> &lhs,
                 const Eigen::DenseBase<DerivedRHS> &rhs) const {
@@ -477,7 +658,7 @@ public:
     m_fcheb = m_kernel_matrix * m_W;
 
     // Last compute f ðxÞ at the observation points xi by interpolation:
-    lhs = m_row_Rn_matrix * m_fcheb;
+    lhs += m_row_Rn_matrix * m_fcheb;
   }
 };
 
@@ -523,10 +704,26 @@ public:
   /// Evaluates a h2 matrix linear operator given by \p expr \p if_expr,
   /// and particle sets \p a and \p b on a vector rhs and
   /// accumulates the result in vector lhs
-  template <typename VectorLHS, typename VectorRHS>
-  void evaluate(VectorLHS &lhs, const VectorRHS &rhs) const {
+  template <typename LHSType, typename RHSType>
+  void evaluate(std::vector<LHSType> &lhs,
+                const std::vector<RHSType> &rhs) const {
     m_h2_matrix.matrix_vector_multiply(lhs, 1.0, false, rhs);
   }
+
+  /// Evaluates a h2 matrix linear operator on each column of \p rhs and
+  /// accumulates the result in the same column of \p lhs. H2Lib only
+  /// provides a matrix-vector product, so the columns are multiplied one
+  /// at a time
+  template <typename DerivedLHS, typename DerivedRHS>
+  void evaluate(Eigen::DenseBase<DerivedLHS> &lhs,
+                const Eigen::DenseBase<DerivedRHS> &rhs) const {
+    CHECK(lhs.cols() == rhs.cols(), "lhs and rhs have different columns");
+    for (typename DerivedRHS::Index i = 0; i < rhs.cols(); ++i) {
+      auto lhs_col = lhs.derived().col(i);
+      m_h2_matrix.matrix_vector_multiply(lhs_col, 1.0, false,
+                                         rhs.derived().col(i));
+    }
+  }
 };
 #endif
 
@@ -569,10 +766,24 @@ public:
   /// Evaluates a matrix-free linear operator given by \p expr \p if_expr,
   /// and particle sets \p a and \p b on a vector rhs and
   /// accumulates the result in vector lhs
-  template <typename VectorLHS, typename VectorRHS>
-  void evaluate(VectorLHS &lhs, const VectorRHS &rhs) const {
+  template <typename LHSType, typename RHSType>
+  void evaluate(std::vector<LHSType> &lhs,
+                const std::vector<RHSType> &rhs) const {
     m_fmm.matrix_vector_multiply(lhs, rhs);
   }
+
+  /// Evaluates a matrix-free linear operator on each column of \p rhs and
+  /// accumulates the result in the same column of \p lhs. The expansions
+  /// only hold a single vector, so the columns are multiplied one at a time
+  template <typename DerivedLHS, typename DerivedRHS>
+  void evaluate(Eigen::DenseBase<DerivedLHS> &lhs,
+                const Eigen::DenseBase<DerivedRHS> &rhs) const {
+    CHECK(lhs.cols() == rhs.cols(), "lhs and rhs have different columns");
+    for (typename DerivedRHS::Index i = 0; i < rhs.cols(); ++i) {
+      auto lhs_col = lhs.derived().col(i);
+      m_fmm.matrix_vector_multiply(lhs_col, rhs.derived().col(i));
+    }
+  }
 };
 
 template <typename RowElements, typename ColElements, typename FRadius,
@@ -600,11 +811,55 @@ public:
   static const size_t BlockRows = base_type::BlockRows;
   static const size_t BlockCols = base_type::BlockCols;
 
+private:
+  typedef std::vector<Block, Eigen::aligned_allocator<Block>> vector_block;
+
+  bool m_use_cache;
+  bool m_cache_values;
+  mutable std::vector<size_t> m_cache_row_offsets;
+  mutable std::vector<size_t> m_cache_col_indices;
+  mutable std::vector<double_d> m_cache_dx;
+  mutable vector_block m_cache_blocks;
+  mutable std::vector<double_d> m_cache_row_positions;
+  mutable std::vector<double_d> m_cache_col_positions;
+
+public:
   KernelSparse(const RowElements &row_elements, const ColElements &col_elements,
                const FRadius &radius_function, const FWithDx &withdx_function)
       : base_type(row_elements, col_elements,
                   F(col_elements, radius_function, withdx_function)),
-        m_radius_function(radius_function), m_dx_function(withdx_function){};
+        m_radius_function(radius_function), m_dx_function(withdx_function),
+        m_use_cache(false), m_cache_values(false){};
+
+  /// Store the sparsity pattern of the operator in compressed sparse row
+  /// (CSR) format the first time it is evaluated, and reuse it for later
+  /// evaluations rather than doing a neighbour search for every row. If
+  /// \p cache_values is true, the kernel values are also stored, so the
+  /// kernel function is only called when the cache is built. Only do this
+  /// if the kernel function depends on nothing other than the particle
+  /// positions.
+  ///
+  /// The cache is rebuilt whenever the positions of either the row or column
+  /// particles have changed (or particles have been added, removed or
+  /// reordered) since it was last built
+  ///
+  void enable_cache(const bool cache_values = false) {
+    m_use_cache = true;
+    m_cache_values = cache_values;
+    clear_cache();
+  }
+
+  /// Stop using (and free) the cached sparsity pattern
+  ///
+  void disable_cache() {
+    m_use_cache = false;
+    clear_cache();
+  }
+
+  /// Returns the number of non-zero blocks in the cached sparsity pattern
+  /// (zero if the cache has not been built)
+  ///
+  size_t cache_size() const { return m_cache_col_indices.size(); }
 
   /*
    * shouldn't need this anymore....
@@ -636,6 +891,9 @@ public:
     const_cast<MatrixType &>(matrix).setZero();
 
     // sparse a x b block
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
     for (size_t i = 0; i < na; ++i) {
       const_row_reference ai = a[i];
       const double radius = m_radius_function(ai);
@@ -652,6 +910,10 @@ public:
     }
   }
 
+  /// Appends the non-zeros of the kernel to \p triplets, offset by \p
+  /// startI and \p startJ. A first pass counts the non-zeros in each row,
+  /// then the triplet vector is resized once and each row is written in
+  /// parallel to its own range
   template <typename Triplet>
   void assemble(std::vector<Triplet> &triplets, const size_t startI = 0,
                 const size_t startJ = 0) const {
@@ -660,12 +922,24 @@ public:
     const ColElements &b = this->m_col_elements;
 
     const size_t na = a.size();
+    const size_t block_size = BlockRows * BlockCols;
+
+    std::vector<size_t> offsets(na + 1);
+    count_row_blocks(offsets.data());
+    offsets[na] = 0;
+    detail::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(), 0);
+
+    const size_t start = triplets.size();
+    triplets.resize(start + offsets[na] * block_size);
 
     // sparse a x b block
-    // std::cout << "sparse a x b block" << std::endl;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
     for (size_t i = 0; i < na; ++i) {
       const_row_reference ai = a[i];
       const double radius = m_radius_function(ai);
+      size_t k = start + offsets[i] * block_size;
       for (auto pairj =
                euclidean_search(b.get_query(), get<position>(ai), radius);
            pairj != false; ++pairj) {
@@ -674,10 +948,68 @@ public:
         const size_t j = &get<position>(bj) - get<position>(b).data();
         const Block element = static_cast<Block>(m_dx_function(dx, ai, bj));
         for (size_t ii = 0; ii < BlockRows; ++ii) {
-          for (size_t jj = 0; jj < BlockCols; ++jj) {
-            triplets.push_back(Triplet(i * BlockRows + ii + startI,
-                                       j * BlockCols + jj + startJ,
-                                       element(ii, jj)));
+          for (size_t jj = 0; jj < BlockCols; ++jj, ++k) {
+            triplets[k] =
+                Triplet(i * BlockRows + ii + startI,
+                        j * BlockCols + jj + startJ, element(ii, jj));
+          }
+        }
+      }
+    }
+  }
+
+  template <typename StorageIndex>
+  void count_nonzeros(StorageIndex *counts) const {
+    const size_t na = this->m_row_elements.size();
+    std::vector<size_t> row_blocks(na);
+    count_row_blocks(row_blocks.data());
+    for (size_t i = 0; i < na; ++i) {
+      for (size_t ii = 0; ii < BlockRows; ++ii) {
+        counts[i * BlockRows + ii] += row_blocks[i] * BlockCols;
+      }
+    }
+  }
+
+  template <typename StorageIndex>
+  void assemble_rows(StorageIndex *cursor, StorageIndex *inner, Scalar *values,
+                     const size_t startJ = 0) const {
+
+    const RowElements &a = this->m_row_elements;
+    const ColElements &b = this->m_col_elements;
+
+    const size_t na = a.size();
+
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < na; ++i) {
+      const_row_reference ai = a[i];
+      const double radius = m_radius_function(ai);
+
+      // the neighbour search does not return the column particles in order,
+      // so sort them before writing the row
+      std::vector<std::pair<size_t, double_d>> neighbours;
+      for (auto pairj =
+               euclidean_search(b.get_query(), get<position>(ai), radius);
+           pairj != false; ++pairj) {
+        neighbours.emplace_back(
+            &get<position>(*pairj) - get<position>(b).data(), pairj.dx());
+      }
+      std::sort(neighbours.begin(), neighbours.end(),
+                [](const std::pair<size_t, double_d> &x,
+                   const std::pair<size_t, double_d> &y) {
+                  return x.first < y.first;
+                });
+
+      for (const auto &neighbour : neighbours) {
+        const size_t j = neighbour.first;
+        const Block element =
+            static_cast<Block>(m_dx_function(neighbour.second, ai, b[j]));
+        for (size_t ii = 0; ii < BlockRows; ++ii) {
+          StorageIndex &k = cursor[i * BlockRows + ii];
+          for (size_t jj = 0; jj < BlockCols; ++jj, ++k) {
+            inner[k] = j * BlockCols + jj + startJ;
+            values[k] = element(ii, jj);
           }
         }
       }
@@ -700,6 +1032,21 @@ public:
     ASSERT(na == rhs.size(), "lhs vector has incompatible size");
     ASSERT(b.size() == lhs.size(), "rhs vector has incompatible size");
 
+    if (m_use_cache) {
+      update_cache();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+      for (size_t i = 0; i < na; ++i) {
+        for (size_t k = m_cache_row_offsets[i];
+             k < m_cache_row_offsets[i + 1]; ++k) {
+          const size_t j = m_cache_col_indices[k];
+          lhs[i] += cached_block(k, a[i], b[j]) * rhs[j];
+        }
+      }
+      return;
+    }
+
 #ifdef HAVE_OPENMP
 #pragma omp parallel for
 #endif
@@ -731,6 +1078,23 @@ public:
 
     const size_t na = a.size();
 
+    if (m_use_cache) {
+      update_cache();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+      for (size_t i = 0; i < na; ++i) {
+        for (size_t k = m_cache_row_offsets[i];
+             k < m_cache_row_offsets[i + 1]; ++k) {
+          const size_t j = m_cache_col_indices[k];
+          lhs.template middleRows<BlockRows>(i * BlockRows) +=
+              cached_block(k, a[i], b[j]) *
+              rhs.template middleRows<BlockCols>(j * BlockCols);
+        }
+      }
+      return;
+    }
+
 #ifdef HAVE_OPENMP
 #pragma omp parallel for
 #endif
@@ -743,9 +1107,147 @@ public:
         const_position_reference dx = pairj.dx();
         const_col_reference bj = *pairj;
         const size_t j = &get<position>(bj) - get<position>(b).data();
-        lhs.template segment<BlockRows>(i * BlockRows) +=
+        lhs.template middleRows<BlockRows>(i * BlockRows) +=
             m_dx_function(dx, ai, bj) *
-            rhs.template segment<BlockCols>(j * BlockCols);
+            rhs.template middleRows<BlockCols>(j * BlockCols);
+      }
+    }
+  }
+
+private:
+  void clear_cache() {
+    m_cache_row_offsets.clear();
+    m_cache_col_indices.clear();
+    m_cache_dx.clear();
+    m_cache_blocks.clear();
+    m_cache_row_positions.clear();
+    m_cache_col_positions.clear();
+  }
+
+  /// returns true if the positions of @p elements are the same as the
+  /// positions stored in @p cached_positions
+  template <typename Elements>
+  static bool positions_unchanged(const Elements &elements,
+                                  const std::vector<double_d> &cached_positions) {
+    if (elements.size() != cached_positions.size()) {
+      return false;
+    }
+    const auto &positions = get<position>(elements);
+    for (size_t i = 0; i < cached_positions.size(); ++i) {
+      if ((positions[i] != cached_positions[i]).any()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// returns the block for non-zero @p k of the cache, between row particle
+  /// @p ai and column particle @p bj
+  Block cached_block(const size_t k, const_row_reference ai,
+                     const_col_reference bj) const {
+    if (m_cache_values) {
+      return m_cache_blocks[k];
+    } else {
+      return static_cast<Block>(m_dx_function(m_cache_dx[k], ai, bj));
+    }
+  }
+
+  /// (re)builds the CSR sparsity pattern if either particle set has moved
+  /// since it was last built. The neighbour search is done twice, once to
+  /// count the non-zeros in each row and once to fill them in, so that both
+  /// passes can be done in parallel over the rows
+  // writes the number of column particles within the search radius of each
+  // row particle to \p counts
+  void count_neighbours(size_t *counts) const {
+    const RowElements &a = this->m_row_elements;
+    const ColElements &b = this->m_col_elements;
+    const size_t na = a.size();
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < na; ++i) {
+      const_row_reference ai = a[i];
+      const double radius = m_radius_function(ai);
+      size_t count = 0;
+      for (auto pairj =
+               euclidean_search(b.get_query(), get<position>(ai), radius);
+           pairj != false; ++pairj) {
+        ++count;
+      }
+      counts[i] = count;
+    }
+  }
+
+  // writes the number of non-zero blocks in each block row to \p counts,
+  // reusing the cached sparsity pattern if it is enabled
+  void count_row_blocks(size_t *counts) const {
+    if (m_use_cache) {
+      update_cache();
+      const size_t na = this->m_row_elements.size();
+      for (size_t i = 0; i < na; ++i) {
+        counts[i] = m_cache_row_offsets[i + 1] - m_cache_row_offsets[i];
+      }
+    } else {
+      count_neighbours(counts);
+    }
+  }
+
+  void update_cache() const {
+    const RowElements &a = this->m_row_elements;
+    const ColElements &b = this->m_col_elements;
+    const size_t na = a.size();
+
+    if (m_cache_row_offsets.size() == na + 1 &&
+        positions_unchanged(a, m_cache_row_positions) &&
+        positions_unchanged(b, m_cache_col_positions)) {
+      return;
+    }
+
+    LOG(2, "KernelSparse: building cached sparsity pattern for " << na
+                                                                 << " rows");
+
+    m_cache_row_positions.assign(get<position>(a).begin(),
+                                 get<position>(a).end());
+    m_cache_col_positions.assign(get<position>(b).begin(),
+                                 get<position>(b).end());
+
+    // count non-zeros in each row
+    m_cache_row_offsets.resize(na + 1);
+    count_neighbours(m_cache_row_offsets.data());
+    m_cache_row_offsets[na] = 0;
+    detail::exclusive_scan(m_cache_row_offsets.begin(),
+                           m_cache_row_offsets.end(),
+                           m_cache_row_offsets.begin(), 0);
+
+    // fill in column indices and either the dx or the kernel values
+    const size_t nnz = m_cache_row_offsets[na];
+    m_cache_col_indices.resize(nnz);
+    if (m_cache_values) {
+      m_cache_blocks.resize(nnz);
+      m_cache_dx.clear();
+    } else {
+      m_cache_dx.resize(nnz);
+      m_cache_blocks.clear();
+    }
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < na; ++i) {
+      const_row_reference ai = a[i];
+      const double radius = m_radius_function(ai);
+      size_t k = m_cache_row_offsets[i];
+      for (auto pairj =
+               euclidean_search(b.get_query(), get<position>(ai), radius);
+           pairj != false; ++pairj, ++k) {
+        const_position_reference dx = pairj.dx();
+        const_col_reference bj = *pairj;
+        m_cache_col_indices[k] =
+            &get<position>(bj) - get<position>(b).data();
+        if (m_cache_values) {
+          m_cache_blocks[k] = static_cast<Block>(m_dx_function(dx, ai, bj));
+        } else {
+          m_cache_dx[k] = dx;
+        }
       }
     }
   }
@@ -801,6 +1303,13 @@ public:
   void assemble(std::vector<Triplet> &triplets, const size_t startI = 0,
                 const size_t startJ = 0) const {}
 
+  template <typename StorageIndex>
+  void count_nonzeros(StorageIndex *counts) const {}
+
+  template <typename StorageIndex>
+  void assemble_rows(StorageIndex *cursor, StorageIndex *inner, Scalar *values,
+                     const size_t startJ = 0) const {}
+
   /// Evaluates a matrix-free linear operator given by \p expr \p if_expr,
   /// and particle sets \p a and \p b on a vector rhs and
   /// accumulates the result in vector lhs
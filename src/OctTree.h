@@ -112,6 +112,8 @@ class HyperOctree : public neighbour_search_base<HyperOctree<Traits>, Traits,
       vector_unsigned_int_iterator;
   typedef typename Traits::vector_unsigned_int vector_unsigned_int;
   typedef typename Traits::vector_int vector_int;
+  typedef detail::octree_tag_type tag_type;
+  typedef typename Traits::template vector_type<tag_type>::type vector_tag;
   typedef typename Traits::unsigned_int_d unsigned_int_d;
   typedef typename Traits::template vector_type<vint2>::type vector_int2;
   static const unsigned int dimension = Traits::dimension;
@@ -128,7 +130,8 @@ class HyperOctree : public neighbour_search_base<HyperOctree<Traits>, Traits,
   friend base_type;
 
 public:
-  HyperOctree() : base_type(), m_max_level(32 / dimension - 2) {
+  HyperOctree()
+      : base_type(), m_max_level(detail::octree_max_level(dimension)) {
 
     // need to init a tree with 1 level (for 0 particles) in case
     // someone does a query on an empty data structure
@@ -318,7 +321,7 @@ private:
   int m_max_level;
   unsigned m_number_of_levels;
 
-  vector_int m_tags;
+  vector_tag m_tags;
   vector_int m_nodes;
   vector_int2 m_leaves;
 
@@ -328,7 +331,7 @@ private:
 template <typename Traits> void HyperOctree<Traits>::build_tree() {
   m_nodes.clear();
   m_leaves.clear();
-  vector_int active_nodes(1, 0);
+  vector_tag active_nodes(1, 0);
 
   LOG(4, "octree: building tree with max_level = " << m_max_level);
 
@@ -343,7 +346,7 @@ template <typename Traits> void HyperOctree<Traits>::build_tree() {
      ******************************************/
 
     // New children: 2^D quadrants per active node
-    vector_int children(nchild * active_nodes.size());
+    vector_tag children(nchild * active_nodes.size());
 
     // For each active node, generate the tag mask for each of its 2^D children
     detail::tabulate(
@@ -362,9 +365,12 @@ template <typename Traits> void HyperOctree<Traits>::build_tree() {
     detail::lower_bound(m_tags.begin(), m_tags.end(), children.begin(),
                         children.end(), lower_bounds.begin());
 
-    int length = (1 << (m_max_level - level) * dimension) - 1;
+    const tag_type length =
+        (tag_type(1) << (m_max_level - level) * dimension) - 1;
 
-    auto plus_length = [=] CUDA_HOST_DEVICE(const int i) { return i + length; };
+    auto plus_length = [=] CUDA_HOST_DEVICE(const tag_type i) {
+      return i + length;
+    };
     detail::upper_bound(
         m_tags.begin(), m_tags.end(),
         Traits::make_transform_iterator(children.begin(), plus_length),
@@ -483,7 +489,7 @@ template <typename traits> struct HyperOctree<traits>::classify_point {
   classify_point(const bbox<dimension> &b, int lvl) : box(b), max_level(lvl) {}
 
   // Classify a point
-  inline CUDA_HOST_DEVICE int operator()(const double_d &p) {
+  inline CUDA_HOST_DEVICE tag_type operator()(const double_d &p) {
     return detail::point_to_tag(p, box, max_level);
   }
 };
@@ -494,14 +500,14 @@ template <typename traits> struct HyperOctree<traits>::child_index_to_tag_mask {
   // mask for lower n bits, where n is the number of dimensions
   const static unsigned mask = nchild - 1;
 
-  typedef typename vector_int::const_pointer ptr_type;
+  typedef typename vector_tag::const_pointer ptr_type;
   ptr_type m_nodes;
 
   child_index_to_tag_mask(int lvl, int max_lvl, ptr_type nodes)
       : level(lvl), max_level(max_lvl), m_nodes(nodes) {}
 
-  inline CUDA_HOST_DEVICE int operator()(int idx) const {
-    int tag = m_nodes[idx / nchild];
+  inline CUDA_HOST_DEVICE tag_type operator()(int idx) const {
+    tag_type tag = m_nodes[idx / nchild];
     int which_child = (idx & mask);
     return detail::child_tag_mask(tag, which_child, level, max_level,
                                   dimension);
@@ -698,7 +704,8 @@ private:
 ///
 template <typename Traits> struct HyperOctreeQuery {
   const static unsigned int dimension = Traits::dimension;
-  const static unsigned int m_max_tree_depth = 32 / dimension - 2;
+  const static unsigned int m_max_tree_depth =
+      detail::octree_max_level(dimension);
 
   typedef Traits traits_type;
   typedef typename Traits::raw_pointer raw_pointer;
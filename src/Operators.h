@@ -187,23 +187,38 @@ public:
     assemble_impl(matrix, detail::make_index_sequence<NI * NJ>());
   }
 
+  /// Assembles the operator into a sparse matrix. The non-zeros in each row
+  /// are first counted, then each kernel writes its rows in parallel
+  /// directly into the compressed storage of a row-major matrix. A
+  /// column-major \p matrix is converted from this row-major matrix
   template <int _Options, typename _StorageIndex>
   void assemble(Eigen::SparseMatrix<Scalar, _Options, _StorageIndex> &matrix) {
     const size_t na = rows();
     const size_t nb = cols();
-    // matrix.resize(na,nb);
     CHECK((static_cast<size_t>(matrix.rows()) == na) &&
               (static_cast<size_t>(matrix.cols()) == nb),
           "matrix size is not compatible with expression.");
 
-    typedef Eigen::Triplet<Scalar> triplet_type;
-    std::vector<triplet_type> tripletList;
-    // TODO: can we estimate this better?
-    tripletList.reserve(na * 5);
+    Eigen::SparseMatrix<Scalar, Eigen::RowMajor, _StorageIndex> row_major;
+    assemble_compressed(row_major);
+    matrix = row_major;
+  }
 
-    assemble_impl(tripletList, detail::make_index_sequence<NI * NJ>());
+  template <typename _StorageIndex>
+  void
+  assemble(Eigen::SparseMatrix<Scalar, Eigen::RowMajor, _StorageIndex> &matrix) {
+    const size_t na = rows();
+    const size_t nb = cols();
+    CHECK((static_cast<size_t>(matrix.rows()) == na) &&
+              (static_cast<size_t>(matrix.cols()) == nb),
+          "matrix size is not compatible with expression.");
+
+    assemble_compressed(matrix);
+  }
 
-    matrix.setFromTriplets(tripletList.begin(), tripletList.end());
+  /// Appends the non-zeros of the operator to \p triplets
+  void assemble(std::vector<Eigen::Triplet<Scalar>> &triplets) const {
+    assemble_impl(triplets, detail::make_index_sequence<NI * NJ>());
   }
 
   template <std::size_t... I>
@@ -264,6 +279,47 @@ public:
     block.assemble(matrix);
   }
 
+  template <typename _StorageIndex>
+  void assemble_compressed(
+      Eigen::SparseMatrix<Scalar, Eigen::RowMajor, _StorageIndex> &matrix)
+      const {
+    const size_t na = rows();
+
+    // count the non-zeros in each row, then scan to get the row offsets
+    std::vector<_StorageIndex> cursor(na + 1, 0);
+    count_nonzeros_impl(cursor.data(), detail::make_index_sequence<NI * NJ>());
+    detail::exclusive_scan(cursor.begin(), cursor.end(), cursor.begin(), 0);
+
+    matrix.resize(na, cols());
+    matrix.resizeNonZeros(cursor[na]);
+    std::copy(cursor.begin(), cursor.end(), matrix.outerIndexPtr());
+
+    // blocks are written in order of their column, so the column indices of
+    // each row stay sorted
+    assemble_rows_impl(cursor.data(), matrix.innerIndexPtr(),
+                       matrix.valuePtr(),
+                       detail::make_index_sequence<NI * NJ>());
+  }
+
+  template <typename _StorageIndex, std::size_t... I>
+  void count_nonzeros_impl(_StorageIndex *counts,
+                           detail::index_sequence<I...>) const {
+    int dummy[] = {0, (std::get<I>(m_blocks).count_nonzeros(
+                           counts + start_row<I / NJ>()),
+                       void(), 0)...};
+    static_cast<void>(dummy);
+  }
+
+  template <typename _StorageIndex, std::size_t... I>
+  void assemble_rows_impl(_StorageIndex *cursor, _StorageIndex *inner,
+                          Scalar *values, detail::index_sequence<I...>) const {
+    int dummy[] = {0, (std::get<I>(m_blocks).assemble_rows(
+                           cursor + start_row<I / NJ>(), inner, values,
+                           start_col<I % NJ>()),
+                       void(), 0)...};
+    static_cast<void>(dummy);
+  }
+
   template <std::size_t... I>
   void assemble_impl(std::vector<Eigen::Triplet<Scalar>> &triplets,
                      detail::index_sequence<I...>) const {
@@ -300,14 +356,22 @@ public:
 /// \param col_particles The columns of the linear operator index this
 ///                      first particle set
 /// \param function A function object that returns the value of the operator
-///                 for a given particle pair
+///                 for a given particle pair. If \p function instead takes a
+///                 pair of positions, the operator is evaluated using a
+///                 faster evaluator specialised for position-only kernels
 ///
 ///
 /// \tparam RowParticles The type of the row particle set
 /// \tparam ColParticles The type of the column particle set
 /// \tparam F The type of the function object
 template <typename RowParticles, typename ColParticles, typename F,
-          typename Kernel = KernelDense<RowParticles, ColParticles, F>,
+          typename Kernel = KernelDense<
+              RowParticles, ColParticles,
+              typename std::conditional<
+                  detail::is_position_function<RowParticles, ColParticles,
+                                               F>::value,
+                  detail::position_kernel<RowParticles, ColParticles, F>,
+                  F>::type>,
           typename Operator = MatrixReplacement<1, 1, std::tuple<Kernel>>>
 Operator create_dense_operator(const RowParticles &row_particles,
                                const ColParticles &col_particles,
@@ -80,7 +80,10 @@ namespace Aboria {
 ///  (for other variables such as velocity, density etc) and is
 ///  optionally embedded within a cuboidal spatial domain (for neighbourhood
 ///  searches) that can be periodic or not. Each particle also has its own
-///  random number generator that is seeded via its own unique id.
+///  random number generator that is seeded via its own unique id. If
+///  `ABORIA_COUNTER_BASED_RNG` is defined there is no per-particle generator,
+///  and random numbers are instead generated from the container seed, the
+///  particle id and a container-wide random step (see get_generator()).
 ///
 ///  For example, the following creates a set of particles which each have
 ///  (along with the standard variables such as position, id etc) a
@@ -224,7 +227,11 @@ public:
   /// to \a *this
   Particles(const particles_type &other)
       : data(other.data), next_id(other.next_id), searchable(other.searchable),
-        seed(other.seed), search(other.search) {}
+        seed(other.seed), search(other.search) {
+#ifdef ABORIA_COUNTER_BASED_RNG
+    random_step = other.random_step;
+#endif
+  }
 
   /// range-based copy-constructor. performs deep copying of all
   /// particles from \p first to \p last
@@ -268,8 +275,10 @@ public:
     // overwrite id, alive and random generator
     reference i = *(end() - 1);
     Aboria::get<id>(i) = this->next_id++;
+#ifndef ABORIA_COUNTER_BASED_RNG
     Aboria::get<generator>(i) =
         generator_type((seed + uint32_t(Aboria::get<id>(i))));
+#endif
     Aboria::get<alive>(i) = true;
 
     if (searchable && update_neighbour_search) {
@@ -289,10 +298,37 @@ public:
   /// for each particle is set to \p value plus the particle's id
   void set_seed(const uint32_t value) {
     seed = value;
+#ifndef ABORIA_COUNTER_BASED_RNG
     detail::for_each(begin(), end(),
                      detail::set_seed_lambda<raw_reference>(seed));
+#endif
   }
 
+  /// returns the base seed of the container
+  uint32_t get_seed() const { return seed; }
+
+#ifdef ABORIA_COUNTER_BASED_RNG
+  /// returns the current random step of the container. Together with the
+  /// base seed and a particle's id this determines the random numbers drawn
+  /// for that particle
+  uint64_t get_random_step() const { return random_step; }
+
+  /// set the current random step to \p value
+  void set_random_step(const uint64_t value) { random_step = value; }
+
+  /// increment the random step, so that subsequent draws give new random
+  /// numbers. This is called after every symbolic assignment to the container
+  void advance_random_step() { ++random_step; }
+
+  /// returns a generator for the particle with id \p id, for the current
+  /// random step. Use different values of \p draw to obtain independent
+  /// streams within a single step
+  generator_type get_generator(const size_t id,
+                               const uint64_t draw = 0) const {
+    return make_generator(seed, id, random_step, draw);
+  }
+#endif
+
   /// push a new particle with position \p position
   /// to the back of the container. All other variables for the new particle
   /// are left at the defaults
@@ -304,10 +340,50 @@ public:
 
   /// push the particles in \p particles to the back of the container
   void push_back(const particles_type &particles) {
-    for (const value_type &i : particles) {
-      this->push_back(i, false);
+    append(particles.begin(), particles.end());
+  }
+
+  /// append the range of particles pointed to by \p first and \p last to the
+  /// back of the container.
+  ///
+  /// Unlike repeated calls to push_back(), the container is resized once, the
+  /// new particles are given unique ids (and their random generators seeded)
+  /// in parallel, and the neighbour search data structure is updated once for
+  /// the whole batch. The `id` and `alive` variables of the range are
+  /// overwritten.
+  ///
+  /// \param first iterator to the first particle to append
+  /// \param last iterator to one past the last particle to append
+  /// \param update_neighbour_search the default is to update the neighbour
+  /// search set this to false to not update \sa update_positions()
+  template <typename InputIterator>
+  void append(InputIterator first, InputIterator last,
+              bool update_neighbour_search = true) {
+    const size_t old_n = this->size();
+    const size_t n = std::distance(first, last);
+    if (n == 0) {
+      return;
+    }
+
+    // resize every variable once and copy across the new particles
+    traits_type::resize(data, old_n + n);
+    detail::copy(first, last, begin() + old_n);
+
+    // overwrite id, alive and random generator
+    const size_t *start_id_pointer =
+        iterator_to_raw_pointer(get<id>(data).begin() + old_n);
+    detail::for_each(begin() + old_n, end(),
+                     detail::resize_lambda<raw_reference>(seed, next_id,
+                                                          start_id_pointer));
+    next_id += n;
+
+    if (searchable && update_neighbour_search) {
+      if (search.ordered()) {
+        update_positions(begin(), end());
+      } else {
+        update_positions(begin() + old_n, end());
+      }
     }
-    update_positions(end() - particles.size(), end());
   }
 
   /// pop (delete) the particle at the end of the container
@@ -466,6 +542,14 @@ public:
     searchable = true;
   }
 
+  /// Returns a reference to the neighbour search data structure. This can be
+  /// used to set options that are specific to a particular data structure
+  /// (e.g. CellListOrdered::set_cell_ordering())
+  search_type &get_neighbour_search() { return search; }
+
+  /// Returns a const reference to the neighbour search data structure
+  const search_type &get_neighbour_search() const { return search; }
+
   /// Returns the query_type object that can be used for neighbourhood queries.
   /// This object is designed to be as lightweight as possible so that it can
   /// by copied (for example to the GPU)
@@ -691,6 +775,11 @@ private:
   /// update_end are the same as given to update_particles(). This function
   /// reorders particles within this range according to the \p order_start and
   /// \p order_end range, using a gather.
+  ///
+  /// The gather is done one variable at a time through a temporary buffer
+  /// the size of that variable, so the peak memory use is the size of the
+  /// container plus its largest variable, rather than twice the size of the
+  /// container
   void reorder(iterator update_begin, iterator update_end,
                const typename vector_int::const_iterator &order_start,
                const typename vector_int::const_iterator &order_end) {
@@ -701,27 +790,16 @@ private:
     const size_t n_alive = order_end - order_start;
     const size_t old_n = size();
     const size_t new_n = old_n - (n_update - n_alive);
-    if (n_alive > old_n / 2) {
-      traits_type::resize(other_data, new_n);
-      // copy non-update region to other data buffer
-      detail::copy(begin(), update_begin, traits_type::begin(other_data));
-      // gather update_region according to order to other data buffer
-      detail::gather(order_start, order_end, traits_type::begin(data),
-                     traits_type::begin(other_data) + (update_begin - begin()));
-      // swap to using other data buffer
-      data.swap(other_data);
-      search.update_iterators(begin(), end());
-    } else {
-      traits_type::resize(other_data, n_alive);
-      // gather update_region to other buffer
-      detail::gather(order_start, order_end, traits_type::begin(data),
-                     traits_type::begin(other_data));
-      traits_type::resize(data, new_n);
-      // copy other buffer back to current data buffer
-      detail::copy(traits_type::begin(other_data), traits_type::end(other_data),
-                   update_begin);
-      search.update_iterators(begin(), end());
-    }
+
+    // gather update region according to order, one variable at a time
+    mpl::for_each<mpl::range_c<int, 0, traits_type::N>>(
+        detail::reorder_variable<data_type,
+                                 typename vector_int::const_iterator>(
+            data, order_start, order_end, update_begin - begin()));
+
+    // remove the dead particles from the end
+    traits_type::resize(data, new_n);
+    search.update_iterators(begin(), end());
     if (ABORIA_LOG_LEVEL >= 4) {
       std::cout << "particle ids:\n";
       for (auto i = begin(); i != end(); ++i) {
@@ -734,14 +812,15 @@ private:
   template <class InputIterator>
   iterator insert_dispatch(iterator position, InputIterator first,
                            InputIterator last, std::false_type) {
-    // TODO: this is very inefficient, but need to handle normal iterators
-    // to value_type. Could improve....
-    if (first == last)
+    // handle normal iterators to value_type by inserting default particles
+    // and then copying the range across
+    const size_t index = position - begin();
+    const size_t n = std::distance(first, last);
+    if (n == 0)
       return position;
-    for (InputIterator it = last; it != first; --it) {
-      position = insert(position, *it);
-    }
-    return insert(position, *first);
+    traits_type::insert(data, position, n, value_type());
+    detail::copy(first, last, begin() + index);
+    return begin() + index;
   }
 
   template <class InputIterator>
@@ -753,9 +832,6 @@ private:
   /// Contains the particle data, implemented as a std::tuple of Level 0 vectors
   data_type data;
 
-  /// A secondary buffer to copy particle data to, if needed
-  data_type other_data;
-
   /// The next available id number
   int next_id;
 
@@ -765,6 +841,11 @@ private:
   /// The base random seed for the container
   uint32_t seed;
 
+#ifdef ABORIA_COUNTER_BASED_RNG
+  /// The random step for counter-based random number generation
+  uint64_t random_step = 0;
+#endif
+
   /// The neighbourhood search data structure
   search_type search;
 
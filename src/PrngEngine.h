@@ -307,6 +307,22 @@ public:
     encrypt_counter();
   }
 
+  // set both the key and the counter, encrypting the counter only once
+  CUDA_HOST_DEVICE
+  void set_key_and_counter(uint64_t k0, uint64_t k1, uint64_t s1,
+                           uint64_t s2) {
+    _k[0] = k0;
+    _k[1] = k1;
+    _k[2] = 0;
+    _k[3] = 0;
+    _s[0] = 0;
+    _s[1] = s1;
+    _s[2] = s2;
+    _s[3] = 0;
+    _o_counter = 0;
+    encrypt_counter();
+  }
+
   // versioning
   CUDA_HOST_DEVICE
   uint32_t version() { return 5; }
@@ -6,6 +6,22 @@
 namespace Aboria {
 
 typedef sitmo::prng_engine generator_type;
+
+#ifdef ABORIA_COUNTER_BASED_RNG
+/// returns a counter-based generator for a single draw of the particle with
+/// id \p id. No per-particle state is needed, the Threefish key is set to
+/// (\p seed, \p id) and the counter to (0, \p draw, \p step), so that the
+/// stream is uniquely determined by the container seed, the particle id, the
+/// container's random step and the draw number within that step.
+CUDA_HOST_DEVICE
+inline generator_type make_generator(const uint32_t seed, const uint64_t id,
+                                     const uint64_t step,
+                                     const uint64_t draw = 0) {
+  generator_type gen;
+  gen.set_key_and_counter(seed, id, draw, step);
+  return gen;
 }
+#endif
+} // namespace Aboria
 
 #endif // RANDOM_H_
@@ -53,7 +53,9 @@ OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "Log.h"
 #include <cmath>
 #include <iostream>
+#include <limits>
 #include <queue>
+#include <vector>
 
 namespace Aboria {
 
@@ -852,6 +854,354 @@ CUDA_HOST_DEVICE Iterator get_neighbouring_buckets(const Query &query) {
   return Iterator(query);
 }
 
+namespace detail {
+
+///
+/// @brief converts an accumulated norm value (see @ref distance_helper) back
+/// to a distance
+///
+template <int LNormNumber>
+inline double accumulated_norm_to_distance(const double accum) {
+  switch (LNormNumber) {
+  case -1:
+  case 0:
+  case 1:
+    return accum;
+  case 2:
+    return std::sqrt(accum);
+  default:
+    return std::pow(accum, 1.0 / LNormNumber);
+  }
+}
+
+///
+/// @brief a bounded max-heap of (accumulated distance, particle index) pairs,
+/// used to keep track of the k nearest candidates found so far
+///
+class knn_heap {
+public:
+  typedef std::pair<double, int> value_type;
+
+  explicit knn_heap(const size_t k) : m_k(k) { m_heap.reserve(k); }
+
+  ///
+  /// @brief returns true if the heap holds k candidates
+  ///
+  bool full() const { return m_heap.size() == m_k; }
+
+  ///
+  /// @brief returns the accumulated distance of the furthest candidate, or
+  /// infinity if the heap is not yet full
+  ///
+  double max_distance() const {
+    return full() ? m_heap.front().first
+                  : std::numeric_limits<double>::infinity();
+  }
+
+  ///
+  /// @brief adds a candidate, removing the furthest candidate if the heap
+  /// is full
+  ///
+  void push(const double accum, const int index) {
+    const value_type candidate(accum, index);
+    if (!full()) {
+      m_heap.push_back(candidate);
+      std::push_heap(m_heap.begin(), m_heap.end());
+    } else if (candidate < m_heap.front()) {
+      std::pop_heap(m_heap.begin(), m_heap.end());
+      m_heap.back() = candidate;
+      std::push_heap(m_heap.begin(), m_heap.end());
+    }
+  }
+
+  ///
+  /// @brief returns the candidates sorted by increasing distance (ties are
+  /// broken by particle index)
+  ///
+  std::vector<value_type> &sorted() {
+    std::sort_heap(m_heap.begin(), m_heap.end());
+    return m_heap;
+  }
+
+private:
+  size_t m_k;
+  std::vector<value_type> m_heap;
+};
+
+///
+/// @brief adds all the particles in @p bucket to the heap, using the minimum
+/// image distance for periodic domains
+///
+template <int LNormNumber, typename Query>
+void knn_scan_bucket(const Query &query,
+                     const typename Query::reference bucket,
+                     const typename Query::double_d &centre, knn_heap &heap) {
+  typedef typename Query::traits_type::position position;
+  typedef typename Query::double_d double_d;
+  const double_d *positions = get<position>(query.get_particles_begin());
+  const auto &bounds = query.get_bounds();
+  const auto &periodic = query.get_periodic();
+  for (auto p = query.get_bucket_particles(bucket); p != false; ++p) {
+    const double_d &pj = get<position>(*p);
+    double accum = 0;
+    for (size_t d = 0; d < Query::dimension; ++d) {
+      double dx = pj[d] - centre[d];
+      if (periodic[d]) {
+        const double length = bounds.bmax[d] - bounds.bmin[d];
+        dx -= std::round(dx / length) * length;
+      }
+      accum = distance_helper<LNormNumber>::accumulate_norm(accum, dx);
+    }
+    heap.push(accum, &pj - positions);
+  }
+}
+
+///
+/// @brief k nearest neighbour search for cell lists. Searches in expanding
+/// shells of buckets around the bucket containing @p centre, until the
+/// distance to the unsearched region is greater than the furthest of the k
+/// candidates
+///
+template <int LNormNumber, typename Query>
+void knn_search_impl(const Query &query,
+                     const typename Query::double_d &centre, knn_heap &heap,
+                     std::true_type) {
+  const unsigned int D = Query::dimension;
+  typedef typename Query::double_d double_d;
+  typedef typename Query::int_d int_d;
+  typedef typename Query::child_iterator child_iterator;
+
+  const auto &bounds = query.get_bounds();
+  const auto &periodic = query.get_periodic();
+  const int_d &end_bucket = query.get_end_bucket();
+  const auto bucket_bounds =
+      query.get_bounds(child_iterator(int_d::Constant(0), int_d::Constant(1)));
+  const double_d side_length = bucket_bounds.bmax - bucket_bounds.bmin;
+
+  // the range of bucket offsets from the centre bucket that can contain
+  // particles. For periodic dimensions this is a window covering all the
+  // buckets once
+  int_d centre_bucket, min_offset, max_offset;
+  int max_shell = 0;
+  for (size_t d = 0; d < D; ++d) {
+    const int n = end_bucket[d] + 1;
+    centre_bucket[d] = std::min(
+        std::max(static_cast<int>(std::floor((centre[d] - bounds.bmin[d]) /
+                                             side_length[d])),
+                 0),
+        end_bucket[d]);
+    if (periodic[d]) {
+      min_offset[d] = -(n - 1) / 2;
+      max_offset[d] = n / 2;
+    } else {
+      min_offset[d] = -centre_bucket[d];
+      max_offset[d] = end_bucket[d] - centre_bucket[d];
+    }
+    max_shell = std::max(max_shell, std::max(-min_offset[d], max_offset[d]));
+  }
+
+  for (int shell = 0; shell <= max_shell; ++shell) {
+    // search all the buckets in this shell
+    int_d shell_min, shell_max;
+    for (size_t d = 0; d < D; ++d) {
+      shell_min[d] = std::max(-shell, min_offset[d]);
+      shell_max[d] = std::min(shell, max_offset[d]) + 1;
+    }
+    for (lattice_iterator<D> offset(shell_min, shell_max); offset != false;
+         ++offset) {
+      // skip buckets in the interior of the shell, already searched
+      bool on_shell = false;
+      int_d bucket;
+      for (size_t d = 0; d < D; ++d) {
+        on_shell |= std::abs((*offset)[d]) == shell;
+        bucket[d] = centre_bucket[d] + (*offset)[d];
+        if (periodic[d]) {
+          const int n = end_bucket[d] + 1;
+          bucket[d] = ((bucket[d] % n) + n) % n;
+        }
+      }
+      if (on_shell) {
+        knn_scan_bucket<LNormNumber>(query, bucket, centre, heap);
+      }
+    }
+
+    // lower bound on the distance to any particle outside the searched
+    // region
+    double min_gap = std::numeric_limits<double>::infinity();
+    for (size_t d = 0; d < D; ++d) {
+      const bool covered_below = -shell <= min_offset[d];
+      const bool covered_above = shell >= max_offset[d];
+      if (periodic[d] ? !(covered_below && covered_above) : !covered_below) {
+        min_gap = std::min(min_gap, centre[d] - bounds.bmin[d] -
+                                        (centre_bucket[d] - shell) *
+                                            side_length[d]);
+      }
+      if (periodic[d] ? !(covered_below && covered_above) : !covered_above) {
+        min_gap = std::min(min_gap, bounds.bmin[d] +
+                                        (centre_bucket[d] + shell + 1) *
+                                            side_length[d] -
+                                        centre[d]);
+      }
+    }
+    if (min_gap == std::numeric_limits<double>::infinity() ||
+        heap.max_distance() <
+            distance_helper<LNormNumber>::get_value_to_accumulate(min_gap)) {
+      break;
+    }
+  }
+}
+
+///
+/// @brief k nearest neighbour search for trees. Uses a best-first traversal,
+/// visiting nodes in order of their distance to @p centre and skipping any
+/// node further away than the furthest of the k candidates
+///
+template <int LNormNumber, typename Query>
+void knn_search_impl(const Query &query,
+                     const typename Query::double_d &centre, knn_heap &heap,
+                     std::false_type) {
+  typedef typename Query::child_iterator child_iterator;
+  typedef std::pair<double, child_iterator> node_type;
+  struct further {
+    bool operator()(const node_type &a, const node_type &b) const {
+      return a.first > b.first;
+    }
+  };
+
+  const auto &bounds = query.get_bounds();
+  const auto &periodic = query.get_periodic();
+  auto node_distance = [&](const child_iterator &ci) {
+    const auto node_bounds = query.get_bounds(ci);
+    double accum = 0;
+    for (size_t d = 0; d < Query::dimension; ++d) {
+      double gap = std::max(0.0, std::max(node_bounds.bmin[d] - centre[d],
+                                          centre[d] - node_bounds.bmax[d]));
+      if (periodic[d] && gap > 0) {
+        const double length = bounds.bmax[d] - bounds.bmin[d];
+        gap = std::min(gap, node_bounds.bmin[d] + length - centre[d]);
+        gap = std::min(gap, centre[d] - node_bounds.bmax[d] + length);
+      }
+      accum = distance_helper<LNormNumber>::accumulate_norm(accum, gap);
+    }
+    return accum;
+  };
+
+  std::priority_queue<node_type, std::vector<node_type>, further> nodes;
+  for (auto ci = query.get_children(); ci != false; ++ci) {
+    nodes.push(node_type(node_distance(ci), ci));
+  }
+  while (!nodes.empty() && nodes.top().first <= heap.max_distance()) {
+    const child_iterator ci = nodes.top().second;
+    nodes.pop();
+    if (query.is_leaf_node(*ci)) {
+      knn_scan_bucket<LNormNumber>(query, *ci, centre, heap);
+    } else {
+      for (auto child = query.get_children(ci); child != false; ++child) {
+        const double accum = node_distance(child);
+        if (accum <= heap.max_distance()) {
+          nodes.push(node_type(accum, child));
+        }
+      }
+    }
+  }
+}
+
+template <int LNormNumber, typename Query>
+void knn_search(const Query &query, typename Query::double_d centre,
+                knn_heap &heap) {
+  // periodic domains: map the centre into the domain
+  const auto &bounds = query.get_bounds();
+  const auto &periodic = query.get_periodic();
+  for (size_t d = 0; d < Query::dimension; ++d) {
+    if (periodic[d]) {
+      const double length = bounds.bmax[d] - bounds.bmin[d];
+      centre[d] -= std::floor((centre[d] - bounds.bmin[d]) / length) * length;
+    }
+  }
+  knn_search_impl<LNormNumber>(
+      query, centre, heap,
+      std::is_same<typename Query::child_iterator,
+                   lattice_iterator<Query::dimension>>());
+}
+
+} // namespace detail
+
+///
+/// @brief returns the @p k nearest neighbours of a point
+///
+/// For the cell list data structures (@ref CellList, @ref CellListOrdered)
+/// the search expands in shells of buckets around @p centre, for the trees
+/// (@ref Kdtree, @ref HyperOctree, @ref KdtreeNanoflann) it uses a best-first
+/// traversal. Periodic domains use the minimum image distance. If there are
+/// fewer than @p k particles, all the particles are returned
+///
+/// @tparam LNormNumber the p-norm used to measure distance (default 2)
+/// @param query the query object of the spatial data structure
+/// @param centre the point to search around
+/// @param k the number of neighbours to find
+/// @return a vector of (distance, particle index) pairs, sorted by increasing
+/// distance. Ties are broken by particle index
+///
+template <int LNormNumber = 2, typename Query>
+std::vector<std::pair<double, int>>
+knn_search(const Query &query, const typename Query::double_d &centre,
+           const size_t k) {
+  detail::knn_heap heap(std::min(k, query.number_of_particles()));
+  if (k > 0) {
+    detail::knn_search<LNormNumber>(query, centre, heap);
+  }
+  std::vector<std::pair<double, int>> &result = heap.sorted();
+  for (auto &i : result) {
+    i.first = detail::accumulated_norm_to_distance<LNormNumber>(i.first);
+  }
+  return std::move(result);
+}
+
+///
+/// @brief finds the @p k nearest neighbours of each point in the range
+/// [@p first, @p last), in parallel if OpenMP is enabled
+///
+/// The results are stored row-wise in @p indices and @p distances, which are
+/// resized to `k*(last-first)`. If there are fewer than @p k particles, the
+/// remaining entries are set to -1 and infinity respectively
+///
+/// @tparam LNormNumber the p-norm used to measure distance (default 2)
+/// @param query the query object of the spatial data structure
+/// @param first random access iterator to the first point
+/// @param last random access iterator to one past the last point
+/// @param k the number of neighbours to find
+/// @param indices output particle indices
+/// @param distances output distances
+///
+/// @see knn_search(const Query&, const typename Query::double_d&, const
+/// size_t)
+///
+template <int LNormNumber = 2, typename Query, typename PointIterator>
+void knn_search(const Query &query, PointIterator first, PointIterator last,
+                const size_t k, std::vector<int> &indices,
+                std::vector<double> &distances) {
+  const size_t n = std::distance(first, last);
+  indices.assign(n * k, -1);
+  distances.assign(n * k, std::numeric_limits<double>::infinity());
+  const size_t kmax = std::min(k, query.number_of_particles());
+  if (kmax == 0) {
+    return;
+  }
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+  for (size_t i = 0; i < n; ++i) {
+    detail::knn_heap heap(kmax);
+    detail::knn_search<LNormNumber>(query, *(first + i), heap);
+    const std::vector<std::pair<double, int>> &result = heap.sorted();
+    for (size_t j = 0; j < result.size(); ++j) {
+      indices[i * k + j] = result[j].second;
+      distances[i * k + j] =
+          detail::accumulated_norm_to_distance<LNormNumber>(result[j].first);
+    }
+  }
+}
+
 } // namespace Aboria
 
 #endif
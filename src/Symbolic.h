@@ -361,12 +361,14 @@ template <typename L1, typename L2> Dx<L1, L2> create_dx(L1 &la, L2 &lb) {
 
 /// a symbolic class used to return a normally distributed random variable. This
 /// uses the random number generator of the current particle to generate the
-/// random variable
+/// random variable (or, if `ABORIA_COUNTER_BASED_RNG` is defined, a
+/// counter-based generator keyed on the particle's id)
 struct Normal : proto::terminal<detail::normal>::type {};
 
 /// a symbolic class used to return a uniformly distributed random variable.
 /// This uses the random number generator of the current particle to generate
-/// the random variable
+/// the random variable (or, if `ABORIA_COUNTER_BASED_RNG` is defined, a
+/// counter-based generator keyed on the particle's id)
 struct Uniform : proto::terminal<detail::uniform>::type {};
 
 /// a symbolic class that, when evaluated, returns a Vect3d class.
@@ -250,7 +250,9 @@ struct TraitsCommon<std::tuple<TYPES...>, DomainD, SelfD, traits>
   typedef typename position::value_type position_value_type;
   typedef alive::value_type alive_value_type;
   typedef id::value_type id_value_type;
+#ifndef ABORIA_COUNTER_BASED_RNG
   typedef generator::value_type random_value_type;
+#endif
 
   typedef typename traits::template vector_type<position_value_type>::type
       position_vector_type;
@@ -258,10 +260,37 @@ struct TraitsCommon<std::tuple<TYPES...>, DomainD, SelfD, traits>
       alive_vector_type;
   typedef
       typename traits::template vector_type<id_value_type>::type id_vector_type;
+
+  typedef traits traits_type;
+
+#ifdef ABORIA_COUNTER_BASED_RNG
+  // random numbers are generated from (seed, id, step), so there is no
+  // per-particle generator variable
+  typedef mpl::vector<position, id, alive, TYPES...> mpl_type_vector;
+
+  typedef tuple<typename position_vector_type::iterator,
+                typename id_vector_type::iterator,
+                typename alive_vector_type::iterator,
+                typename traits::template vector_type<
+                    typename TYPES::value_type>::type::iterator...>
+      tuple_of_iterators_type;
+
+  typedef tuple<typename position_vector_type::const_iterator,
+                typename id_vector_type::const_iterator,
+                typename alive_vector_type::const_iterator,
+                typename traits::template vector_type<
+                    typename TYPES::value_type>::type::const_iterator...>
+      tuple_of_const_iterators_type;
+
+  // need a std::tuple here, rather than a thrust one...
+  typedef std::tuple<position_vector_type, id_vector_type, alive_vector_type,
+                     typename traits::template vector_type<
+                         typename TYPES::value_type>::type...>
+      vectors_data_type;
+#else
   typedef typename traits::template vector_type<random_value_type>::type
       random_vector_type;
 
-  typedef traits traits_type;
   typedef mpl::vector<position, id, alive, generator, TYPES...> mpl_type_vector;
 
   typedef tuple<typename position_vector_type::iterator,
@@ -286,6 +315,7 @@ struct TraitsCommon<std::tuple<TYPES...>, DomainD, SelfD, traits>
                      typename traits::template vector_type<
                          typename TYPES::value_type>::type...>
       vectors_data_type;
+#endif
 
   typedef
       typename Aboria::zip_iterator<tuple_of_iterators_type, mpl_type_vector>
@@ -408,8 +438,9 @@ struct TraitsCommon<std::tuple<TYPES...>, DomainD, SelfD, traits>
   template <std::size_t... I>
   static void insert_impl(data_type &data, iterator position, size_t n,
                           const value_type &val, detail::index_sequence<I...>) {
-    int dummy[] = {0, (get_by_index<I>(data).insert(position, n,
-                                                    get_by_index<I>(val)))...};
+    int dummy[] = {0, (get_by_index<I>(data).insert(get_by_index<I>(position),
+                                                    n, get_by_index<I>(val)),
+                       0)...};
     static_cast<void>(dummy);
   }
 
@@ -538,7 +569,7 @@ struct TraitsCommon<std::tuple<TYPES...>, DomainD, SelfD, traits>
   template <typename Indices = detail::make_index_sequence<N>>
   static void insert(data_type &data, iterator position, size_t n,
                      const value_type &val) {
-    insert_impl(data, position, val, n, Indices());
+    insert_impl(data, position, n, val, Indices());
   }
 
   template <class InputIterator,
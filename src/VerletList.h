@@ -0,0 +1,345 @@
+/*
+
+Copyright (c) 2005-2016, University of Oxford.
+All rights reserved.
+
+University of Oxford means the Chancellor, Masters and Scholars of the
+University of Oxford, having an administrative office at Wellington
+Square, Oxford OX1 2JD, UK.
+
+This file is part of Aboria.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice,
+   this list of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+ * Neither the name of the University of Oxford nor the names of its
+   contributors may be used to endorse or promote products derived from this
+   software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+*/
+
+#ifndef VERLET_LIST_H_
+#define VERLET_LIST_H_
+
+#include "Get.h"
+#include "Log.h"
+#include "NeighbourSearchBase.h"
+#include "Search.h"
+#include "detail/Algorithms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace Aboria {
+
+///
+/// @brief A Verlet neighbour list built on top of any spatial data structure
+///
+/// For each particle, the list stores the indices of all the other particles
+/// within a distance of `cutoff + skin`. The indices are stored contiguously
+/// in compressed sparse row (CSR) format, i.e. a vector of offsets of length
+/// `n+1` and a single vector of neighbour indices.
+///
+/// The list only needs to be rebuilt once the maximum displacement of any
+/// particle since the last build exceeds half the skin distance, or if
+/// particles have been added or removed. Call update() every timestep, after
+/// the particle positions have been updated, and it will rebuild the list
+/// only when this is required. If an ordered spatial data structure has
+/// reordered the particles, the list is permuted rather than rebuilt.
+///
+/// Note that the list contains neighbours within `cutoff + skin`, so the
+/// distance between each pair still needs to be checked against `cutoff`
+///
+/// @tparam Query the query type of the spatial data structure (e.g.
+/// `Particles::query_type`)
+/// @tparam LNormNumber the p-norm used to measure distance (default 2)
+///
+template <typename Query, int LNormNumber = 2> class VerletList {
+  typedef typename Query::traits_type traits_type;
+  typedef typename traits_type::double_d double_d;
+  typedef typename traits_type::bool_d bool_d;
+  typedef typename traits_type::position position;
+  static const unsigned int dimension = traits_type::dimension;
+
+public:
+  typedef std::vector<size_t> offsets_type;
+  typedef std::vector<int> indices_type;
+  typedef typename indices_type::const_iterator const_iterator;
+
+  ///
+  /// @brief constructs an empty Verlet list
+  ///
+  /// @param cutoff the interaction cutoff distance
+  /// @param skin the additional skin distance. Particles within
+  /// `cutoff + skin` of each other are stored in the list
+  ///
+  VerletList(const double cutoff, const double skin)
+      : m_cutoff(cutoff), m_skin(skin) {}
+
+  ///
+  /// @brief rebuilds the list if any particle has moved more than half the
+  /// skin distance since the last build, or particles have been added or
+  /// removed
+  ///
+  /// If the particles have only been reordered (e.g. by an update of an
+  /// ordered spatial data structure), the existing list is permuted to match
+  /// the new order, which is much cheaper than a rebuild
+  ///
+  /// @param query the query object of the spatial data structure
+  /// @return true if the list was rebuilt, false otherwise
+  ///
+  bool update(const Query &query) {
+    const size_t n = query.number_of_particles();
+    if (n != size()) {
+      rebuild(query);
+      return true;
+    }
+
+    const auto &begin = query.get_particles_begin();
+    const double_d *positions = get<position>(begin);
+    const size_t *ids = get<id>(begin);
+    const bool_d periodic = query.get_periodic();
+    const double_d domain_length =
+        query.get_bounds().bmax - query.get_bounds().bmin;
+    const double max_displacement2 = std::pow(0.5 * m_skin, 2);
+
+    // find the index of each particle at the last build, and check how far
+    // it has moved since then
+    std::vector<int> old_index(n);
+    int rebuild_list = 0;
+    int reordered = 0;
+#ifdef HAVE_OPENMP
+#pragma omp parallel for reduction(| : rebuild_list, reordered)
+#endif
+    for (size_t i = 0; i < n; ++i) {
+      int index = i;
+      if (ids[i] != m_ids[i]) {
+        reordered |= 1;
+        auto it = std::lower_bound(
+            m_sorted_ids.begin(), m_sorted_ids.end(),
+            std::make_pair(ids[i], 0),
+            [](const std::pair<size_t, int> &a,
+               const std::pair<size_t, int> &b) { return a.first < b.first; });
+        if (it == m_sorted_ids.end() || it->first != ids[i]) {
+          rebuild_list |= 1;
+          continue;
+        }
+        index = it->second;
+      }
+      old_index[i] = index;
+      double_d dx = positions[i] - m_positions[index];
+      for (size_t d = 0; d < dimension; ++d) {
+        if (periodic[d]) {
+          dx[d] -= std::round(dx[d] / domain_length[d]) * domain_length[d];
+        }
+      }
+      if (dx.squaredNorm() > max_displacement2) {
+        rebuild_list |= 1;
+      }
+    }
+
+    if (rebuild_list) {
+      rebuild(query);
+      return true;
+    }
+    if (reordered) {
+      permute(old_index);
+    }
+    return false;
+  }
+
+  ///
+  /// @brief rebuild the list, using a neighbour search over @p query
+  ///
+  void rebuild(const Query &query) {
+    LOG(2, "VerletList: rebuilding list with cutoff = "
+               << m_cutoff << " and skin = " << m_skin);
+    const size_t n = query.number_of_particles();
+    const double max_distance = m_cutoff + m_skin;
+    const auto &begin = query.get_particles_begin();
+    const double_d *positions = get<position>(begin);
+
+    // count the number of neighbours of each particle
+    m_offsets.resize(n + 1);
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < n; ++i) {
+      size_t count = 0;
+      for (auto j = distance_search<LNormNumber>(query, positions[i],
+                                                 max_distance);
+           j != false; ++j) {
+        if (&get<position>(*j) != &positions[i]) {
+          ++count;
+        }
+      }
+      m_offsets[i] = count;
+    }
+    m_offsets[n] = 0;
+    detail::exclusive_scan(m_offsets.begin(), m_offsets.end(),
+                           m_offsets.begin(), 0);
+
+    // fill in the neighbour indices
+    m_indices.resize(m_offsets[n]);
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < n; ++i) {
+      size_t index = m_offsets[i];
+      for (auto j = distance_search<LNormNumber>(query, positions[i],
+                                                 max_distance);
+           j != false; ++j) {
+        const double_d *pj = &get<position>(*j);
+        if (pj != &positions[i]) {
+          m_indices[index++] = pj - positions;
+        }
+      }
+    }
+
+    // store the positions and ids used to build the list
+    m_positions.assign(positions, positions + n);
+    m_ids.assign(get<id>(begin), get<id>(begin) + n);
+    sort_ids();
+  }
+
+  ///
+  /// @brief returns the indices of the neighbours of particle @p i
+  ///
+  /// @param i the index of the particle
+  /// @return an @ref iterator_range of neighbour indices
+  ///
+  iterator_range<const_iterator> get_neighbours(const size_t i) const {
+    return iterator_range<const_iterator>(m_indices.begin() + m_offsets[i],
+                                          m_indices.begin() + m_offsets[i + 1]);
+  }
+
+  ///
+  /// @brief returns the number of neighbours of particle @p i
+  ///
+  size_t number_of_neighbours(const size_t i) const {
+    return m_offsets[i + 1] - m_offsets[i];
+  }
+
+  ///
+  /// @brief returns the number of particles in the list
+  ///
+  size_t size() const { return m_positions.size(); }
+
+  ///
+  /// @brief returns the CSR offsets (of length `size() + 1`)
+  ///
+  const offsets_type &get_offsets() const { return m_offsets; }
+
+  ///
+  /// @brief returns the CSR neighbour indices
+  ///
+  const indices_type &get_indices() const { return m_indices; }
+
+  ///
+  /// @brief returns the cutoff distance
+  ///
+  double get_cutoff() const { return m_cutoff; }
+
+  ///
+  /// @brief returns the skin distance
+  ///
+  double get_skin() const { return m_skin; }
+
+private:
+  // permute the list so that particle i was particle old_index[i] at the
+  // last build
+  void permute(const std::vector<int> &old_index) {
+    LOG(2, "VerletList: permuting list");
+    const size_t n = old_index.size();
+    std::vector<int> new_index(n);
+    offsets_type offsets(n + 1);
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < n; ++i) {
+      new_index[old_index[i]] = i;
+      offsets[i] = number_of_neighbours(old_index[i]);
+    }
+    offsets[n] = 0;
+    detail::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(),
+                           0);
+
+    indices_type indices(m_indices.size());
+    std::vector<double_d> positions(n);
+    std::vector<size_t> ids(n);
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < n; ++i) {
+      size_t index = offsets[i];
+      for (const int j : get_neighbours(old_index[i])) {
+        indices[index++] = new_index[j];
+      }
+      positions[i] = m_positions[old_index[i]];
+      ids[i] = m_ids[old_index[i]];
+    }
+
+    m_offsets.swap(offsets);
+    m_indices.swap(indices);
+    m_positions.swap(positions);
+    m_ids.swap(ids);
+    sort_ids();
+  }
+
+  // sort (id, index) pairs so that the index of a particle at the last build
+  // can be found from its id
+  void sort_ids() {
+    const size_t n = m_ids.size();
+    m_sorted_ids.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      m_sorted_ids[i] = std::make_pair(m_ids[i], static_cast<int>(i));
+    }
+    detail::sort(m_sorted_ids.begin(), m_sorted_ids.end());
+  }
+
+  double m_cutoff;
+  double m_skin;
+  offsets_type m_offsets;
+  indices_type m_indices;
+  std::vector<double_d> m_positions;
+  std::vector<size_t> m_ids;
+  std::vector<std::pair<size_t, int>> m_sorted_ids;
+};
+
+///
+/// @brief creates a @ref VerletList for the spatial data structure with
+/// query object @p query, and builds the list
+///
+/// @param query the query object of the spatial data structure
+/// @param cutoff the interaction cutoff distance
+/// @param skin the additional skin distance
+///
+template <int LNormNumber = 2, typename Query>
+VerletList<Query, LNormNumber>
+create_verlet_list(const Query &query, const double cutoff,
+                   const double skin) {
+  VerletList<Query, LNormNumber> list(cutoff, skin);
+  list.rebuild(query);
+  return list;
+}
+
+} // namespace Aboria
+
+#endif /* VERLET_LIST_H_ */
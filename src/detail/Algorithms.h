@@ -8,6 +8,12 @@
 #include <algorithm>
 #include <omp.h>
 #include <random>
+#include <type_traits>
+#include <vector>
+
+#ifdef HAVE_OPENMP
+#include "OpenMPAlgorithms.h"
+#endif
 
 namespace Aboria {
 
@@ -100,7 +106,11 @@ template <typename T> struct upper_bound_impl {
 
 template <class ForwardIt, class T>
 void fill(ForwardIt first, ForwardIt last, const T &value, std::true_type) {
+#ifdef HAVE_OPENMP
+  openmp::fill(first, last, value);
+#else
   std::fill(first, last, value);
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -118,7 +128,11 @@ void fill(ForwardIt first, ForwardIt last, const T &value) {
 template <class InputIt, class UnaryFunction>
 UnaryFunction for_each(InputIt first, InputIt last, UnaryFunction f,
                        std::true_type) {
+#ifdef HAVE_OPENMP
+  return openmp::for_each(first, last, f);
+#else
   return std::for_each(first, last, f);
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -137,7 +151,12 @@ UnaryFunction for_each(InputIt first, InputIt last, UnaryFunction f) {
 
 template <typename RandomIt>
 void sort(RandomIt start, RandomIt end, std::true_type) {
+#ifdef HAVE_OPENMP
+  openmp::sort(start, end,
+               std::less<typename std::iterator_traits<RandomIt>::value_type>());
+#else
   std::sort(start, end);
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -154,7 +173,11 @@ template <typename RandomIt> void sort(RandomIt start, RandomIt end) {
 template <typename RandomIt, typename StrictWeakOrdering>
 void sort(RandomIt start, RandomIt end, StrictWeakOrdering comp,
           std::true_type) {
+#ifdef HAVE_OPENMP
+  openmp::sort(start, end, comp);
+#else
   std::sort(start, end, comp);
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -170,11 +193,149 @@ void sort(RandomIt start, RandomIt end, StrictWeakOrdering comp) {
   detail::sort(start, end, comp, typename is_std_iterator<RandomIt>::type());
 }
 
+///
+/// @brief maps an integer key to an unsigned integer with the same ordering,
+/// by flipping the sign bit of signed keys
+///
+template <typename T>
+typename std::make_unsigned<T>::type radix_sort_key(const T key) {
+  typedef typename std::make_unsigned<T>::type unsigned_type;
+  return std::is_signed<T>::value
+             ? static_cast<unsigned_type>(key) ^
+                   (unsigned_type(1) << (8 * sizeof(T) - 1))
+             : static_cast<unsigned_type>(key);
+}
+
+///
+/// @brief a stable LSD radix sort of the keys [@p keys, @p keys + @p n) and
+/// their associated @p data, using 8-bit digits
+///
+/// Each digit pass builds a histogram of digits for each thread's block of
+/// keys, scans the histograms (digit-major, then thread) to give every thread
+/// its output offsets, and scatters the keys and data to a second buffer.
+/// Passes over digits that are identical for all the keys are skipped, so
+/// keys within a small range (e.g. bucket indices) only take one or two
+/// passes
+///
+template <typename Key, typename Data>
+void radix_sort_by_key(Key *keys, Data *data, const size_t n) {
+  const unsigned int radix_bits = 8;
+  const unsigned int radix = 1 << radix_bits;
+  const unsigned int max_passes = sizeof(Key) * 8 / radix_bits;
+  typedef typename std::make_unsigned<Key>::type unsigned_type;
+  if (n < 2) {
+    return;
+  }
+
+  // find which digits differ between the keys
+  unsigned_type differ = 0;
+  const unsigned_type first_key = radix_sort_key(keys[0]);
+#ifdef HAVE_OPENMP
+#pragma omp parallel for reduction(| : differ)
+#endif
+  for (size_t i = 1; i < n; ++i) {
+    differ |= radix_sort_key(keys[i]) ^ first_key;
+  }
+  std::vector<unsigned int> shifts;
+  for (unsigned int pass = 0; pass < max_passes; ++pass) {
+    if ((differ >> (pass * radix_bits)) & (radix - 1)) {
+      shifts.push_back(pass * radix_bits);
+    }
+  }
+  if (shifts.empty()) {
+    return;
+  }
+
+  std::vector<Key> keys_buffer(n);
+  std::vector<Data> data_buffer(n);
+  Key *keys_in = keys;
+  Data *data_in = data;
+  Key *keys_out = keys_buffer.data();
+  Data *data_out = data_buffer.data();
+
+#ifdef HAVE_OPENMP
+  const size_t max_nt = omp_get_max_threads();
+#else
+  const size_t max_nt = 1;
+#endif
+  std::vector<size_t> offsets(max_nt * radix);
+
+  for (const unsigned int shift : shifts) {
+#ifdef HAVE_OPENMP
+#pragma omp parallel
+#endif
+    {
+#ifdef HAVE_OPENMP
+      const size_t nt = omp_get_num_threads();
+      const size_t t = omp_get_thread_num();
+#else
+      const size_t nt = 1;
+      const size_t t = 0;
+#endif
+      const size_t begin = n * t / nt;
+      const size_t end = n * (t + 1) / nt;
+      size_t *count = offsets.data() + t * radix;
+
+      std::fill(count, count + radix, 0);
+      for (size_t i = begin; i < end; ++i) {
+        ++count[(radix_sort_key(keys_in[i]) >> shift) & (radix - 1)];
+      }
+
+#ifdef HAVE_OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+      {
+        size_t sum = 0;
+        for (size_t digit = 0; digit < radix; ++digit) {
+          for (size_t tt = 0; tt < nt; ++tt) {
+            const size_t tmp = offsets[tt * radix + digit];
+            offsets[tt * radix + digit] = sum;
+            sum += tmp;
+          }
+        }
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+        const size_t index =
+            count[(radix_sort_key(keys_in[i]) >> shift) & (radix - 1)]++;
+        keys_out[index] = keys_in[i];
+        data_out[index] = data_in[i];
+      }
+    }
+    std::swap(keys_in, keys_out);
+    std::swap(data_in, data_out);
+  }
+
+  // an odd number of passes leaves the result in the buffers
+  if (keys_in != keys) {
+#ifdef HAVE_OPENMP
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < n; ++i) {
+      keys[i] = keys_in[i];
+      data[i] = data_in[i];
+    }
+  }
+}
+
 template <typename T1, typename T2>
-void sort_by_key(T1 start_keys, T1 end_keys, T2 start_data, std::true_type) {
+void sort_by_key(T1 start_keys, T1 end_keys, T2 start_data, std::true_type,
+                 std::true_type) {
+  detail::radix_sort_by_key(&*start_keys, &*start_data,
+                            std::distance(start_keys, end_keys));
+}
+
+template <typename T1, typename T2>
+void sort_by_key(T1 start_keys, T1 end_keys, T2 start_data, std::true_type,
+                 std::false_type) {
   typedef zip_iterator<std::tuple<T1, T2>, mpl::vector<>> pair_zip_type;
 
+#ifdef HAVE_OPENMP
+  openmp::sort(
+#else
   std::sort(
+#endif
       pair_zip_type(start_keys, start_data),
       pair_zip_type(end_keys, start_data + std::distance(start_keys, end_keys)),
       [](auto a, auto b) {
@@ -189,6 +350,19 @@ std::sort(
   */
 }
 
+template <typename T1, typename T2>
+void sort_by_key(T1 start_keys, T1 end_keys, T2 start_data, std::true_type) {
+  typedef typename std::iterator_traits<T1>::value_type key_type;
+  if (start_keys == end_keys) {
+    return;
+  }
+  // use a radix sort for integer keys, otherwise a comparison sort
+  detail::sort_by_key(
+      start_keys, end_keys, start_data, std::true_type(),
+      std::integral_constant<bool, std::is_integral<key_type>::value &&
+                                       !std::is_same<key_type, bool>::value>());
+}
+
 #ifdef HAVE_THRUST
 template <typename T1, typename T2>
 void sort_by_key(T1 start_keys, T1 end_keys, T2 start_data, std::false_type) {
@@ -210,8 +384,13 @@ template <typename ForwardIterator, typename InputIterator,
 void lower_bound(ForwardIterator first, ForwardIterator last,
                  InputIterator values_first, InputIterator values_last,
                  OutputIterator result, std::true_type) {
+#ifdef HAVE_OPENMP
+  openmp::transform(values_first, values_last, result,
+                    detail::lower_bound_impl<ForwardIterator>(first, last));
+#else
   std::transform(values_first, values_last, result,
                  detail::lower_bound_impl<ForwardIterator>(first, last));
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -263,9 +442,13 @@ template <typename ForwardIterator, typename InputIterator,
 void upper_bound(ForwardIterator first, ForwardIterator last,
                  InputIterator values_first, InputIterator values_last,
                  OutputIterator result, std::true_type) {
-
+#ifdef HAVE_OPENMP
+  openmp::transform(values_first, values_last, result,
+                    detail::upper_bound_impl<ForwardIterator>(first, last));
+#else
   std::transform(values_first, values_last, result,
                  detail::upper_bound_impl<ForwardIterator>(first, last));
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -291,8 +474,11 @@ void upper_bound(ForwardIterator first, ForwardIterator last,
 template <class InputIt, class T, class BinaryOperation>
 T reduce(InputIt first, InputIt last, T init, BinaryOperation op,
          std::true_type) {
-
+#ifdef HAVE_OPENMP
+  return openmp::reduce(first, last, init, op);
+#else
   return std::accumulate(first, last, init, op);
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -307,7 +493,7 @@ T reduce(InputIt first, InputIt last, T init, BinaryOperation op,
 template <class InputIt, class T, class BinaryOperation>
 T reduce(InputIt first, InputIt last, T init, BinaryOperation op) {
 
-  detail::reduce(first, last, init, op,
+  return detail::reduce(first, last, init, op,
                  typename is_std_iterator<InputIt>::type());
 }
 
@@ -315,7 +501,11 @@ template <class InputIterator, class OutputIterator, class UnaryOperation>
 OutputIterator transform(InputIterator first, InputIterator last,
                          OutputIterator result, UnaryOperation op,
                          std::true_type) {
+#ifdef HAVE_OPENMP
+  return openmp::transform(first, last, result, op);
+#else
   return std::transform(first, last, result, op);
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -336,21 +526,30 @@ OutputIterator transform(InputIterator first, InputIterator last,
 
 template <class ForwardIterator>
 void sequence(ForwardIterator first, ForwardIterator last, std::true_type) {
+#ifdef HAVE_OPENMP
+  openmp::tabulate(first, last, [](const unsigned int i) { return i; });
+#else
   boost::counting_iterator<unsigned int> count(0);
   std::transform(
       first, last, count, first,
       [](const typename std::iterator_traits<ForwardIterator>::reference,
          const unsigned int i) { return i; });
+#endif
 }
 
 template <class ForwardIterator, typename T>
 void sequence(ForwardIterator first, ForwardIterator last, T init,
               std::true_type) {
+#ifdef HAVE_OPENMP
+  openmp::tabulate(first, last,
+                   [init](const unsigned int i) { return init + i; });
+#else
   boost::counting_iterator<unsigned int> count(init);
   std::transform(
       first, last, count, first,
       [](const typename std::iterator_traits<ForwardIterator>::reference,
          const unsigned int i) { return i; });
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -381,13 +580,16 @@ void sequence(ForwardIterator first, ForwardIterator last, T init) {
 template <typename ForwardIterator, typename UnaryOperation>
 void tabulate(ForwardIterator first, ForwardIterator last,
               UnaryOperation unary_op, std::true_type) {
-
+#ifdef HAVE_OPENMP
+  openmp::tabulate(first, last, unary_op);
+#else
   boost::counting_iterator<unsigned int> count(0);
   std::transform(
       first, last, count, first,
       [&unary_op](
           const typename std::iterator_traits<ForwardIterator>::reference,
           const unsigned int i) { return unary_op(i); });
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -408,7 +610,11 @@ void tabulate(ForwardIterator first, ForwardIterator last,
 template <class ForwardIt, class UnaryPredicate>
 ForwardIt partition(ForwardIt first, ForwardIt last, UnaryPredicate p,
                     std::true_type) {
+#ifdef HAVE_OPENMP
+  return openmp::stable_partition(first, last, p);
+#else
   return std::partition(first, last, p);
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -428,7 +634,11 @@ ForwardIt partition(ForwardIt first, ForwardIt last, UnaryPredicate p) {
 template <class ForwardIt, class UnaryPredicate>
 ForwardIt stable_partition(ForwardIt first, ForwardIt last, UnaryPredicate p,
                            std::true_type) {
+#ifdef HAVE_OPENMP
+  return openmp::stable_partition(first, last, p);
+#else
   return std::stable_partition(first, last, p);
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -465,7 +675,11 @@ template <class ForwardIt> ForwardIt unique(ForwardIt first, ForwardIt last) {
 template <typename InputIterator, typename OutputIterator>
 OutputIterator copy(InputIterator first, InputIterator last,
                     OutputIterator result, std::true_type) {
+#ifdef HAVE_OPENMP
+  return openmp::copy(first, last, result);
+#else
   return std::copy(first, last, result);
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -489,13 +703,17 @@ OutputIterator
 transform_exclusive_scan(InputIterator first, InputIterator last,
                          OutputIterator result, UnaryFunction unary_op, T init,
                          AssociativeOperator binary_op, std::true_type) {
-
+#ifdef HAVE_OPENMP
+  return openmp::transform_exclusive_scan(first, last, result, unary_op, init,
+                                          binary_op);
+#else
   const size_t n = last - first;
   result[0] = init;
   for (size_t i = 1; i < n; ++i) {
     result[i] = binary_op(result[i - 1], unary_op(first[i - 1]));
   }
   return result + n;
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -526,7 +744,9 @@ OutputIterator transform_exclusive_scan(InputIterator first, InputIterator last,
 template <class InputIt, class OutputIt>
 OutputIt inclusive_scan(InputIt first, InputIt last, OutputIt d_first,
                         std::true_type) {
-#if __cplusplus >= 201703L
+#if defined(HAVE_OPENMP)
+  return openmp::inclusive_scan(first, last, d_first);
+#elif __cplusplus >= 201703L
   // C++17 code here
   return std::inclusive_scan(first, last, d_first);
 #else
@@ -551,15 +771,18 @@ OutputIt inclusive_scan(InputIt first, InputIt last, OutputIt d_first) {
 template <class InputIt, class OutputIt, class T>
 OutputIt exclusive_scan(InputIt first, InputIt last, OutputIt d_first, T init,
                         std::true_type) {
-#if __cplusplus >= 201703L
+#if defined(HAVE_OPENMP)
+  return openmp::exclusive_scan(first, last, d_first, init);
+#elif __cplusplus >= 201703L
   // C++17 code here
   return std::exclusive_scan(first, last, d_first,init);
 #else
-  if (first != last) {
-    *d_first++ = init;
-    for (; first != last - 1; ++first, ++d_first) {
-      *d_first = *(d_first - 1) + *first;
-    }
+  // note: safe to use with d_first == first
+  T sum = init;
+  for (; first != last; ++first, ++d_first) {
+    const T value = *first;
+    *d_first = sum;
+    sum = sum + value;
   }
   return d_first;
 #endif
@@ -585,14 +808,18 @@ OutputIterator
 exclusive_scan_by_key(InputIterator1 first1, InputIterator1 last1,
                       InputIterator2 first2, OutputIterator result, T init,
                       std::true_type) {
+#ifdef HAVE_OPENMP
+  return openmp::exclusive_scan_by_key(first1, last1, first2, result, init);
+#else
   for (; first1 != last1; ++first2) {
     *result++ = init;
     ++first1;
-    for (; *first1 == *(first1 - 1) && first1 != last1;
+    for (; first1 != last1 && *first1 == *(first1 - 1);
          ++first1, ++first2, ++result)
       *result = *(result - 1) + *first2;
   }
   return result;
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -620,10 +847,14 @@ template <typename InputIterator1, typename InputIterator2,
           typename RandomAccessIterator>
 void scatter(InputIterator1 first, InputIterator1 last, InputIterator2 map,
              RandomAccessIterator output, std::true_type) {
+#ifdef HAVE_OPENMP
+  openmp::scatter(first, last, map, output);
+#else
   const size_t n = last - first;
   for (size_t i = 0; i < n; ++i) {
     output[map[i]] = first[i];
   }
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -649,13 +880,16 @@ template <typename InputIterator1, typename InputIterator2,
 void scatter_if(InputIterator1 first, InputIterator1 last, InputIterator2 map,
                 InputIterator3 stencil, RandomAccessIterator output,
                 Predicate pred, std::true_type) {
-
+#ifdef HAVE_OPENMP
+  openmp::scatter_if(first, last, map, stencil, output, pred);
+#else
   const size_t n = last - first;
   for (size_t i = 0; i < n; ++i) {
     if (pred(stencil[i])) {
       output[map[i]] = first[i];
     }
   }
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -686,13 +920,19 @@ template <typename InputIterator1, typename InputIterator2,
 void scatter_if(InputIterator1 first, InputIterator1 last, InputIterator2 map,
                 InputIterator3 stencil, RandomAccessIterator output,
                 std::true_type) {
-
+#ifdef HAVE_OPENMP
+  typedef typename std::iterator_traits<InputIterator3>::value_type
+      stencil_type;
+  openmp::scatter_if(first, last, map, stencil, output,
+                     [](const stencil_type &i) { return bool(i); });
+#else
   const size_t n = last - first;
   for (size_t i = 0; i < n; ++i) {
     if (stencil[i]) {
       output[map[i]] = first[i];
     }
   }
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -720,10 +960,14 @@ template <typename InputIterator, typename RandomAccessIterator,
 void gather(InputIterator map_first, InputIterator map_last,
             RandomAccessIterator input_first, OutputIterator result,
             std::true_type) {
+#ifdef HAVE_OPENMP
+  openmp::gather(map_first, map_last, input_first, result);
+#else
   std::transform(map_first, map_last, result,
                  [&input_first](typename InputIterator::value_type const &i) {
                    return input_first[i];
                  });
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -749,6 +993,9 @@ template <typename InputIterator1, typename InputIterator2,
 OutputIterator copy_if(InputIterator1 first, InputIterator1 last,
                        InputIterator2 stencil, OutputIterator result,
                        Predicate pred, std::true_type) {
+#ifdef HAVE_OPENMP
+  return openmp::copy_if(first, last, stencil, result, pred);
+#else
   // TODO: need to parallise this....
   const size_t n = last - first;
   for (size_t i = 0; i < n; ++i) {
@@ -758,6 +1005,7 @@ OutputIterator copy_if(InputIterator1 first, InputIterator1 last,
     }
   }
   return result;
+#endif
 }
 
 #ifdef HAVE_THRUST
@@ -56,8 +56,23 @@ template <typename labels_type, typename dx_type> struct EvalCtx {
   static_assert(dx_size_type::value == dx_size,
                 "dx size not consitent with labels_size");
 
+#ifdef ABORIA_COUNTER_BASED_RNG
+  // nested contexts share the \p draw counter of their parent, so that
+  // repeated normal or uniform draws for the same particle are independent
+  EvalCtx(labels_type labels = fusion::nil(), dx_type dx = fusion::nil(),
+          uint64_t *draw = nullptr)
+      : m_labels(labels), m_dx(dx), m_draw_storage(0),
+        m_draw(draw != nullptr ? draw : &m_draw_storage) {}
+
+  EvalCtx(const EvalCtx &other)
+      : m_labels(other.m_labels), m_dx(other.m_dx),
+        m_draw_storage(other.m_draw_storage),
+        m_draw(other.m_draw == &other.m_draw_storage ? &m_draw_storage
+                                                      : other.m_draw) {}
+#else
   EvalCtx(labels_type labels = fusion::nil(), dx_type dx = fusion::nil())
       : m_labels(labels), m_dx(dx) {}
+#endif
 
   template <typename Expr
             // defaulted template parameters, so we can
@@ -103,6 +118,17 @@ template <typename labels_type, typename dx_type> struct EvalCtx {
     typedef double result_type;
 
     result_type operator()(Expr &expr, EvalCtx const &ctx) const {
+#ifdef ABORIA_COUNTER_BASED_RNG
+      // There is no per-particle generator, so create one from the
+      // container seed, the particle id, the container's random step and the
+      // number of draws already made in this evaluation
+      generator_type gen =
+          proto::value(proto::child_c<1>(expr))
+              .get_particles()
+              .get_generator(get<id>(fusion::at_key<label_type>(ctx.m_labels)),
+                             (*ctx.m_draw)++);
+      return proto::value(proto::child_c<0>(expr))(gen);
+#else
       // Normal and uniform terminal types have a operator() that takes a
       // generator. Pass the random generator for the labeled particle to this
       // operator()
@@ -111,6 +137,7 @@ template <typename labels_type, typename dx_type> struct EvalCtx {
           // normally held as a const &. Could cause problems???
           const_cast<generator_type &>(
               get<generator>(fusion::at_key<label_type>(ctx.m_labels))));
+#endif
     }
   };
 
@@ -237,7 +264,12 @@ template <typename labels_type, typename dx_type> struct EvalCtx {
 
         EvalCtx<map_type, list_type> const new_ctx(
             fusion::make_map<label_a_type, label_b_type>(ai, bi),
-            fusion::make_list(get<position>(bi) - get<position>(ai)));
+            fusion::make_list(get<position>(bi) - get<position>(ai))
+#ifdef ABORIA_COUNTER_BASED_RNG
+                ,
+            ctx.m_draw
+#endif
+        );
 
         sum = accum.functor(sum, proto::eval(expr, new_ctx));
       }
@@ -281,7 +313,12 @@ template <typename labels_type, typename dx_type> struct EvalCtx {
       EvalCtx<map_type, list_type> const new_ctx(
           // fusion::make_map<label_a_type, label_b_type>(ai, *b),
           map_type(ai, *b),
-          list_type(b.dx())); // fusion::make_list(b.dx()));
+          list_type(b.dx()) // fusion::make_list(b.dx()));
+#ifdef ABORIA_COUNTER_BASED_RNG
+              ,
+          ctx.m_draw
+#endif
+      );
 
       sum = accum.functor(sum, proto::eval(expr, new_ctx));
     }
@@ -327,6 +364,10 @@ template <typename labels_type, typename dx_type> struct EvalCtx {
 
   labels_type m_labels;
   dx_type m_dx;
+#ifdef ABORIA_COUNTER_BASED_RNG
+  mutable uint64_t m_draw_storage;
+  uint64_t *m_draw;
+#endif
 };
 
 } // namespace detail
@@ -333,6 +333,36 @@ struct position_kernel {
   }
 };
 
+template <typename F> struct is_position_kernel : std::false_type {};
+
+template <typename RowElements, typename ColElements, typename F>
+struct is_position_kernel<position_kernel<RowElements, ColElements, F>>
+    : std::true_type {};
+
+template <typename T> struct make_void { typedef void type; };
+
+template <typename Signature, typename = void>
+struct is_callable : std::false_type {};
+
+template <typename F, typename... Args>
+struct is_callable<
+    F(Args...),
+    typename make_void<typename std::result_of<F(Args...)>::type>::type>
+    : std::true_type {};
+
+// true if F takes a pair of positions rather than a pair of particle
+// references, in which case it is wrapped in a position_kernel
+template <typename RowElements, typename ColElements, typename F>
+struct is_position_function
+    : std::integral_constant<
+          bool,
+          is_callable<F(const Vector<double, RowElements::dimension> &,
+                        const Vector<double, RowElements::dimension> &)>::
+                  value &&
+              !is_callable<F(typename RowElements::const_reference,
+                             typename ColElements::const_reference)>::value> {
+};
+
 template <typename RowElements, typename ColElements, typename FRadius,
           typename F>
 struct sparse_kernel {
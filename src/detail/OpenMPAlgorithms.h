@@ -0,0 +1,574 @@
+#ifndef OPENMP_ALGORITHMS_H_
+#define OPENMP_ALGORITHMS_H_
+
+#include <algorithm>
+#include <boost/iterator/iterator_categories.hpp>
+#include <numeric>
+#include <omp.h>
+#include <vector>
+
+namespace Aboria {
+
+namespace detail {
+
+///
+/// @brief OpenMP implementations of the host (i.e. `std::vector`) algorithms
+///
+/// These are used by the `std::true_type` overloads in Algorithms.h when
+/// Aboria is compiled with `HAVE_OPENMP` and without Thrust. Each algorithm
+/// only runs in parallel if its iterators are random access and the range is
+/// longer than #serial_cutoff, otherwise it falls back to the equivalent
+/// serial `std` algorithm. As for Thrust, any function objects passed in must
+/// be safe to call concurrently from multiple threads
+///
+namespace openmp {
+
+///
+/// @brief ranges shorter than this are not worth the overhead of starting
+/// a parallel region, so are processed in serial
+///
+constexpr size_t serial_cutoff = 2048;
+
+template <typename T>
+using is_random_access = std::integral_constant<
+    bool, std::is_convertible<typename boost::iterator_traversal<T>::type,
+                              boost::random_access_traversal_tag>::value>;
+
+template <typename T> bool run_in_parallel(const T n) {
+  return static_cast<size_t>(n) >= serial_cutoff && omp_get_max_threads() > 1;
+}
+
+///
+/// @brief divide the range [0, @p n) evenly amongst @p nt threads and return
+/// the start of the block for thread @p t
+///
+inline size_t block_begin(const size_t n, const size_t t, const size_t nt) {
+  return (n * t) / nt;
+}
+
+template <class InputIt, class UnaryFunction>
+UnaryFunction for_each(InputIt first, InputIt last, UnaryFunction f,
+                       std::false_type) {
+  return std::for_each(first, last, f);
+}
+
+template <class InputIt, class UnaryFunction>
+UnaryFunction for_each(InputIt first, InputIt last, UnaryFunction f,
+                       std::true_type) {
+  const auto n = last - first;
+  if (!run_in_parallel(n)) {
+    return std::for_each(first, last, f);
+  }
+#pragma omp parallel for
+  for (decltype(last - first) i = 0; i < n; ++i) {
+    f(*(first + i));
+  }
+  return f;
+}
+
+template <class InputIt, class UnaryFunction>
+UnaryFunction for_each(InputIt first, InputIt last, UnaryFunction f) {
+  return openmp::for_each(first, last, f, is_random_access<InputIt>());
+}
+
+template <class ForwardIt, class T>
+void fill(ForwardIt first, ForwardIt last, const T &value, std::false_type) {
+  std::fill(first, last, value);
+}
+
+template <class ForwardIt, class T>
+void fill(ForwardIt first, ForwardIt last, const T &value, std::true_type) {
+  const auto n = last - first;
+  if (!run_in_parallel(n)) {
+    std::fill(first, last, value);
+    return;
+  }
+#pragma omp parallel for
+  for (decltype(last - first) i = 0; i < n; ++i) {
+    *(first + i) = value;
+  }
+}
+
+template <class ForwardIt, class T>
+void fill(ForwardIt first, ForwardIt last, const T &value) {
+  openmp::fill(first, last, value, is_random_access<ForwardIt>());
+}
+
+template <class InputIterator, class OutputIterator, class UnaryOperation>
+OutputIterator transform(InputIterator first, InputIterator last,
+                         OutputIterator result, UnaryOperation op,
+                         std::false_type) {
+  return std::transform(first, last, result, op);
+}
+
+template <class InputIterator, class OutputIterator, class UnaryOperation>
+OutputIterator transform(InputIterator first, InputIterator last,
+                         OutputIterator result, UnaryOperation op,
+                         std::true_type) {
+  const auto n = last - first;
+  if (!run_in_parallel(n)) {
+    return std::transform(first, last, result, op);
+  }
+#pragma omp parallel for
+  for (decltype(last - first) i = 0; i < n; ++i) {
+    *(result + i) = op(*(first + i));
+  }
+  return result + n;
+}
+
+template <class InputIterator, class OutputIterator, class UnaryOperation>
+OutputIterator transform(InputIterator first, InputIterator last,
+                         OutputIterator result, UnaryOperation op) {
+  return openmp::transform(
+      first, last, result, op,
+      std::integral_constant<bool, is_random_access<InputIterator>::value &&
+                                       is_random_access<OutputIterator>::value>());
+}
+
+template <typename InputIterator, typename OutputIterator>
+OutputIterator copy(InputIterator first, InputIterator last,
+                    OutputIterator result) {
+  typedef typename std::iterator_traits<InputIterator>::reference reference;
+  return openmp::transform(first, last, result,
+                           [](reference i) { return i; });
+}
+
+template <typename InputIterator, typename RandomAccessIterator,
+          typename OutputIterator>
+void gather(InputIterator map_first, InputIterator map_last,
+            RandomAccessIterator input_first, OutputIterator result) {
+  typedef typename std::iterator_traits<InputIterator>::value_type index_type;
+  openmp::transform(
+      map_first, map_last, result,
+      [&input_first](const index_type &i) { return *(input_first + i); });
+}
+
+template <typename InputIterator1, typename InputIterator2,
+          typename RandomAccessIterator>
+void scatter(InputIterator1 first, InputIterator1 last, InputIterator2 map,
+             RandomAccessIterator output) {
+  const auto n = last - first;
+#pragma omp parallel for if (run_in_parallel(n))
+  for (decltype(last - first) i = 0; i < n; ++i) {
+    *(output + *(map + i)) = *(first + i);
+  }
+}
+
+template <typename InputIterator1, typename InputIterator2,
+          typename InputIterator3, typename RandomAccessIterator,
+          typename Predicate>
+void scatter_if(InputIterator1 first, InputIterator1 last, InputIterator2 map,
+                InputIterator3 stencil, RandomAccessIterator output,
+                Predicate pred) {
+  const auto n = last - first;
+#pragma omp parallel for if (run_in_parallel(n))
+  for (decltype(last - first) i = 0; i < n; ++i) {
+    if (pred(*(stencil + i))) {
+      *(output + *(map + i)) = *(first + i);
+    }
+  }
+}
+
+template <class ForwardIterator, typename UnaryOperation>
+void tabulate(ForwardIterator first, ForwardIterator last,
+              UnaryOperation unary_op) {
+  const auto n = last - first;
+#pragma omp parallel for if (run_in_parallel(n))
+  for (decltype(last - first) i = 0; i < n; ++i) {
+    *(first + i) = unary_op(static_cast<unsigned int>(i));
+  }
+}
+
+template <class InputIt, class T, class BinaryOperation>
+T reduce(InputIt first, InputIt last, T init, BinaryOperation op) {
+  const size_t n = last - first;
+  if (!run_in_parallel(n)) {
+    return std::accumulate(first, last, init, op);
+  }
+  std::vector<T> partial(omp_get_max_threads());
+  std::vector<char> has_partial(partial.size(), false);
+#pragma omp parallel
+  {
+    const size_t nt = omp_get_num_threads();
+    const size_t t = omp_get_thread_num();
+    const size_t begin = block_begin(n, t, nt);
+    const size_t end = block_begin(n, t + 1, nt);
+    if (begin < end) {
+      T sum = *(first + begin);
+      for (size_t i = begin + 1; i < end; ++i) {
+        sum = op(sum, *(first + i));
+      }
+      partial[t] = sum;
+      has_partial[t] = true;
+    }
+  }
+  for (size_t t = 0; t < partial.size(); ++t) {
+    if (has_partial[t]) {
+      init = op(init, partial[t]);
+    }
+  }
+  return init;
+}
+
+///
+/// @brief a two-pass parallel scan. The first pass calculates the sum of each
+/// thread's block, these are scanned in serial, and then the second pass
+/// scans each block starting from the sum of the preceeding blocks.
+///
+/// If @p inclusive is false then @p init is used as the first value of the
+/// (exclusive) scan, otherwise it is ignored. Note that @p result can be
+/// equal to @p first
+///
+template <typename InputIterator, typename OutputIterator,
+          typename UnaryFunction, typename T, typename AssociativeOperator>
+OutputIterator scan(InputIterator first, InputIterator last,
+                    OutputIterator result, UnaryFunction unary_op, T init,
+                    AssociativeOperator binary_op, const bool inclusive) {
+  const size_t n = last - first;
+  if (n == 0) {
+    return result;
+  }
+  const size_t max_nt = run_in_parallel(n) ? omp_get_max_threads() : 1;
+  std::vector<T> offsets(max_nt + 1, init);
+  std::vector<char> has_offset(max_nt + 1, !inclusive);
+
+#pragma omp parallel num_threads(max_nt)
+  {
+    const size_t nt = omp_get_num_threads();
+    const size_t t = omp_get_thread_num();
+    const size_t begin = block_begin(n, t, nt);
+    const size_t end = block_begin(n, t + 1, nt);
+
+    // first pass: sum each block
+    if (begin < end && t + 1 < nt) {
+      T sum = unary_op(*(first + begin));
+      for (size_t i = begin + 1; i < end; ++i) {
+        sum = binary_op(sum, unary_op(*(first + i)));
+      }
+      offsets[t + 1] = sum;
+    }
+
+#pragma omp barrier
+#pragma omp single
+    {
+      // scan the block sums, propogating the offset over any empty blocks
+      for (size_t tt = 0; tt + 1 < nt; ++tt) {
+        if (block_begin(n, tt, nt) == block_begin(n, tt + 1, nt)) {
+          offsets[tt + 1] = offsets[tt];
+          has_offset[tt + 1] = has_offset[tt];
+        } else {
+          if (has_offset[tt]) {
+            offsets[tt + 1] = binary_op(offsets[tt], offsets[tt + 1]);
+          }
+          has_offset[tt + 1] = true;
+        }
+      }
+    }
+
+    // second pass: scan each block
+    if (begin < end) {
+      T sum = offsets[t];
+      bool has_sum = has_offset[t];
+      for (size_t i = begin; i < end; ++i) {
+        const T value = unary_op(*(first + i));
+        if (inclusive) {
+          sum = has_sum ? binary_op(sum, value) : value;
+          has_sum = true;
+          *(result + i) = sum;
+        } else {
+          *(result + i) = sum;
+          sum = binary_op(sum, value);
+        }
+      }
+    }
+  }
+  return result + n;
+}
+
+template <typename InputIterator, typename OutputIterator,
+          typename UnaryFunction, typename T, typename AssociativeOperator>
+OutputIterator transform_exclusive_scan(InputIterator first,
+                                        InputIterator last,
+                                        OutputIterator result,
+                                        UnaryFunction unary_op, T init,
+                                        AssociativeOperator binary_op) {
+  return openmp::scan(first, last, result, unary_op, init, binary_op, false);
+}
+
+template <class InputIt, class OutputIt, class T>
+OutputIt exclusive_scan(InputIt first, InputIt last, OutputIt d_first,
+                        T init) {
+  typedef typename std::iterator_traits<OutputIt>::value_type value_type;
+  return openmp::scan(first, last, d_first,
+                      [](const value_type &i) { return i; },
+                      static_cast<value_type>(init), std::plus<value_type>(),
+                      false);
+}
+
+template <class InputIt, class OutputIt>
+OutputIt inclusive_scan(InputIt first, InputIt last, OutputIt d_first) {
+  typedef typename std::iterator_traits<OutputIt>::value_type value_type;
+  return openmp::scan(first, last, d_first,
+                      [](const value_type &i) { return i; }, value_type(),
+                      std::plus<value_type>(), true);
+}
+
+///
+/// @brief a parallel segmented exclusive scan, where each run of equal keys
+/// in [@p first1, @p last1) starts a new scan from @p init.
+///
+/// The first pass scans each thread's block independently, recording the sum
+/// of the last (possibly partial) segment in the block and whether the block
+/// contains the start of a segment. These are combined in serial to give the
+/// carry into each block, which the second pass adds to the elements before
+/// the first segment start in each block
+///
+template <typename InputIterator1, typename InputIterator2,
+          typename OutputIterator, typename T>
+OutputIterator exclusive_scan_by_key(InputIterator1 first1,
+                                     InputIterator1 last1,
+                                     InputIterator2 first2,
+                                     OutputIterator result, T init) {
+  typedef typename std::iterator_traits<OutputIterator>::value_type value_type;
+  const size_t n = last1 - first1;
+  const size_t max_nt = run_in_parallel(n) ? omp_get_max_threads() : 1;
+  std::vector<value_type> tails(max_nt, value_type());
+  std::vector<value_type> carry(max_nt, value_type());
+  std::vector<char> has_start(max_nt, false);
+
+  auto is_start = [&](const size_t i) {
+    return i == 0 || !(*(first1 + i) == *(first1 + i - 1));
+  };
+
+#pragma omp parallel num_threads(max_nt)
+  {
+    const size_t nt = omp_get_num_threads();
+    const size_t t = omp_get_thread_num();
+    const size_t begin = block_begin(n, t, nt);
+    const size_t end = block_begin(n, t + 1, nt);
+
+    // first pass: scan each block, starting at init
+    value_type sum = init;
+    value_type tail = value_type();
+    for (size_t i = begin; i < end; ++i) {
+      if (is_start(i)) {
+        sum = init;
+        tail = value_type();
+        has_start[t] = true;
+      }
+      *(result + i) = sum;
+      sum = sum + *(first2 + i);
+      tail = tail + *(first2 + i);
+    }
+    tails[t] = tail;
+
+#pragma omp barrier
+#pragma omp single
+    {
+      // the carry into a block is the sum of its first segment in all
+      // previous blocks
+      for (size_t tt = 1; tt < nt; ++tt) {
+        carry[tt] = has_start[tt - 1] ? tails[tt - 1]
+                                      : carry[tt - 1] + tails[tt - 1];
+      }
+    }
+
+    // second pass: add carry up to the first segment start in the block
+    if (t > 0) {
+      for (size_t i = begin; i < end && !is_start(i); ++i) {
+        *(result + i) = *(result + i) + carry[t];
+      }
+    }
+  }
+  return result + n;
+}
+
+///
+/// @brief a parallel merge sort. The range is divided into one block per
+/// thread, each block is sorted using `std::sort`, then pairs of
+/// neighbouring blocks are merged (in parallel) using `std::inplace_merge`
+/// until one sorted range remains
+///
+template <typename RandomIt, typename StrictWeakOrdering>
+void sort(RandomIt start, RandomIt end, StrictWeakOrdering comp) {
+  const size_t n = end - start;
+  if (!run_in_parallel(n)) {
+    std::sort(start, end, comp);
+    return;
+  }
+  const int nblocks = omp_get_max_threads();
+  std::vector<size_t> bounds(nblocks + 1);
+  for (int i = 0; i <= nblocks; ++i) {
+    bounds[i] = block_begin(n, i, nblocks);
+  }
+
+#pragma omp parallel for
+  for (int i = 0; i < nblocks; ++i) {
+    std::sort(start + bounds[i], start + bounds[i + 1], comp);
+  }
+
+  for (int width = 1; width < nblocks; width *= 2) {
+#pragma omp parallel for
+    for (int i = 0; i < nblocks; i += 2 * width) {
+      if (i + width < nblocks) {
+        std::inplace_merge(start + bounds[i], start + bounds[i + width],
+                           start + bounds[std::min(i + 2 * width, nblocks)],
+                           comp);
+      }
+    }
+  }
+}
+
+///
+/// @brief a stable parallel partition. Each block counts its number of true
+/// elements, these are scanned to give the output location of every element,
+/// which is then copied to a temporary buffer and back again
+///
+template <class ForwardIt, class UnaryPredicate>
+ForwardIt stable_partition(ForwardIt first, ForwardIt last, UnaryPredicate p,
+                           std::true_type) {
+  typedef typename std::iterator_traits<ForwardIt>::value_type value_type;
+  const size_t n = last - first;
+  if (!run_in_parallel(n)) {
+    return std::stable_partition(first, last, p);
+  }
+  const size_t max_nt = omp_get_max_threads();
+  std::vector<size_t> true_offsets(max_nt + 1, 0);
+  std::vector<size_t> false_offsets(max_nt + 1, 0);
+  std::vector<char> flags(n);
+  std::vector<value_type> buffer(n);
+  size_t n_true = 0;
+
+#pragma omp parallel
+  {
+    const size_t nt = omp_get_num_threads();
+    const size_t t = omp_get_thread_num();
+    const size_t begin = block_begin(n, t, nt);
+    const size_t end = block_begin(n, t + 1, nt);
+
+    size_t count = 0;
+    for (size_t i = begin; i < end; ++i) {
+      flags[i] = p(*(first + i));
+      count += flags[i];
+    }
+    true_offsets[t + 1] = count;
+    false_offsets[t + 1] = (end - begin) - count;
+
+#pragma omp barrier
+#pragma omp single
+    {
+      for (size_t tt = 0; tt < nt; ++tt) {
+        true_offsets[tt + 1] += true_offsets[tt];
+        false_offsets[tt + 1] += false_offsets[tt];
+      }
+      n_true = true_offsets[nt];
+    }
+
+    size_t true_index = true_offsets[t];
+    size_t false_index = n_true + false_offsets[t];
+    for (size_t i = begin; i < end; ++i) {
+      buffer[flags[i] ? true_index++ : false_index++] = *(first + i);
+    }
+
+#pragma omp barrier
+    for (size_t i = begin; i < end; ++i) {
+      *(first + i) = buffer[i];
+    }
+  }
+  return first + n_true;
+}
+
+template <class ForwardIt, class UnaryPredicate>
+ForwardIt stable_partition(ForwardIt first, ForwardIt last, UnaryPredicate p,
+                           std::false_type) {
+  return std::stable_partition(first, last, p);
+}
+
+template <class ForwardIt, class UnaryPredicate>
+ForwardIt stable_partition(ForwardIt first, ForwardIt last, UnaryPredicate p) {
+  return openmp::stable_partition(first, last, p,
+                                  is_random_access<ForwardIt>());
+}
+
+///
+/// @brief parallel stream compaction, the same algorithm as
+/// stable_partition, except that the output is written directly to @p result
+///
+template <typename InputIterator1, typename InputIterator2,
+          typename OutputIterator, typename Predicate>
+OutputIterator copy_if(InputIterator1 first, InputIterator1 last,
+                       InputIterator2 stencil, OutputIterator result,
+                       Predicate pred, std::false_type) {
+  const size_t n = last - first;
+  for (size_t i = 0; i < n; ++i) {
+    if (pred(*(stencil + i))) {
+      *result = *(first + i);
+      ++result;
+    }
+  }
+  return result;
+}
+
+template <typename InputIterator1, typename InputIterator2,
+          typename OutputIterator, typename Predicate>
+OutputIterator copy_if(InputIterator1 first, InputIterator1 last,
+                       InputIterator2 stencil, OutputIterator result,
+                       Predicate pred, std::true_type) {
+  const size_t n = last - first;
+  if (!run_in_parallel(n)) {
+    return openmp::copy_if(first, last, stencil, result, pred,
+                           std::false_type());
+  }
+  std::vector<size_t> offsets(omp_get_max_threads() + 1, 0);
+  size_t n_copied = 0;
+
+#pragma omp parallel
+  {
+    const size_t nt = omp_get_num_threads();
+    const size_t t = omp_get_thread_num();
+    const size_t begin = block_begin(n, t, nt);
+    const size_t end = block_begin(n, t + 1, nt);
+
+    size_t count = 0;
+    for (size_t i = begin; i < end; ++i) {
+      if (pred(*(stencil + i))) {
+        ++count;
+      }
+    }
+    offsets[t + 1] = count;
+
+#pragma omp barrier
+#pragma omp single
+    {
+      for (size_t tt = 0; tt < nt; ++tt) {
+        offsets[tt + 1] += offsets[tt];
+      }
+      n_copied = offsets[nt];
+    }
+
+    size_t index = offsets[t];
+    for (size_t i = begin; i < end; ++i) {
+      if (pred(*(stencil + i))) {
+        *(result + index++) = *(first + i);
+      }
+    }
+  }
+  return result + n_copied;
+}
+
+template <typename InputIterator1, typename InputIterator2,
+          typename OutputIterator, typename Predicate>
+OutputIterator copy_if(InputIterator1 first, InputIterator1 last,
+                       InputIterator2 stencil, OutputIterator result,
+                       Predicate pred) {
+  return openmp::copy_if(
+      first, last, stencil, result, pred,
+      std::integral_constant<bool, is_random_access<InputIterator1>::value &&
+                                       is_random_access<OutputIterator>::value>());
+}
+
+} // namespace openmp
+} // namespace detail
+} // namespace Aboria
+
+#endif
@@ -161,9 +161,8 @@ template <typename T1, typename... T> T1 sum(T1 s, T... ts) {
   return s + sum(ts...);
 }
 
-template <typename Dest, typename Source, typename Block>
-void evalTo_block(Eigen::VectorBlock<Dest> y,
-                  const Eigen::VectorBlock<Source> &rhs, const Block &block) {
+template <typename DestBlock, typename SourceBlock, typename Block>
+void evalTo_block(DestBlock y, const SourceBlock &rhs, const Block &block) {
   block.evaluate(y, rhs);
 }
 
@@ -177,10 +176,10 @@ template <typename Dest, unsigned int NI, unsigned int NJ, typename Blocks,
 void evalTo_unpack_blocks(Dest &y, const MatrixReplacement<NI, NJ, Blocks> &lhs,
                           const Rhs &rhs, const std::tuple<I, J, T1 &> &block,
                           const T &... other_blocks) {
-  evalTo_block(y.segment(lhs.template start_row<I::value>(),
-                         lhs.template size_row<I::value>()),
-               rhs.segment(lhs.template start_col<J::value>(),
-                           lhs.template size_col<J::value>()),
+  evalTo_block(y.middleRows(lhs.template start_row<I::value>(),
+                            lhs.template size_row<I::value>()),
+               rhs.middleRows(lhs.template start_col<J::value>(),
+                              lhs.template size_col<J::value>()),
                std::get<2>(block));
   evalTo_unpack_blocks(y, lhs, rhs, other_blocks...);
 }
@@ -199,14 +198,17 @@ void evalTo_impl(Dest &y, const MatrixReplacement<NI, NJ, Blocks> &lhs,
 } // namespace detail
 } // namespace Aboria
 
-// Implementation of MatrixReplacement * Eigen::DenseVector though a
-// specialization of internal::generic_product_impl:
+// Implementation of MatrixReplacement * Eigen::DenseVector and
+// MatrixReplacement * Eigen::DenseMatrix (i.e. GEMV and GEMM products) though a
+// specialization of internal::generic_product_impl. The rows of the
+// destination and rhs are split between the blocks, and each kernel is
+// given all the columns at once
 namespace Eigen {
 namespace internal {
-template <typename Rhs, unsigned int NI, unsigned int NJ, typename Blocks>
+template <typename Rhs, unsigned int NI, unsigned int NJ, typename Blocks,
+          int ProductType>
 struct generic_product_impl<Aboria::MatrixReplacement<NI, NJ, Blocks>, Rhs,
-                            SparseShape, DenseShape,
-                            GemvProduct> // GEMV stands for matrix-vector
+                            SparseShape, DenseShape, ProductType>
     : generic_product_impl_base<
           Aboria::MatrixReplacement<NI, NJ, Blocks>, Rhs,
           generic_product_impl<Aboria::MatrixReplacement<NI, NJ, Blocks>,
@@ -66,8 +66,10 @@ template <typename Reference> struct resize_lambda {
     const size_t index = &Aboria::get<id>(i) - start_id_pointer;
     Aboria::get<id>(i) = index + next_id;
 
+#ifndef ABORIA_COUNTER_BASED_RNG
     generator_type &gen = Aboria::get<generator>(i);
     gen.seed(seed + uint32_t(Aboria::get<id>(i)));
+#endif
   }
 };
 
@@ -83,6 +85,31 @@ template <typename Reference> struct set_seed_lambda {
   }
 };
 
+// reorders a single variable of a Particles data_type \p data, by gathering
+// according to [order_start, order_end) into a temporary buffer and copying
+// this back to \p data starting at \p offset. Applied to each variable in
+// turn, this only needs temporary storage for one variable at a time
+template <typename DataType, typename IndexIterator> struct reorder_variable {
+  DataType &data;
+  IndexIterator order_start;
+  IndexIterator order_end;
+  size_t offset;
+
+  reorder_variable(DataType &data, const IndexIterator &order_start,
+                   const IndexIterator &order_end, const size_t offset)
+      : data(data), order_start(order_start), order_end(order_end),
+        offset(offset) {}
+
+  template <typename U> void operator()(U i) {
+    auto &variable = Aboria::get_by_index<U::value>(data);
+    typedef typename std::remove_reference<decltype(variable)>::type
+        vector_type;
+    vector_type buffer(order_end - order_start);
+    detail::gather(order_start, order_end, variable.begin(), buffer.begin());
+    detail::copy(buffer.begin(), buffer.end(), variable.begin() + offset);
+  }
+};
+
 template <typename ConstReference> struct is_alive {
   CUDA_HOST_DEVICE
   bool operator()(ConstReference i) const { return Aboria::get<alive>(i); }
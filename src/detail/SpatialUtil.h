@@ -7,6 +7,7 @@
 #include "Vector.h"
 
 #include <bitset>  // std::bitset
+#include <cstdint>
 #include <iomanip> // std::setw
 #include <limits>
 
@@ -32,6 +33,72 @@ template <> CUDA_HOST_DEVICE constexpr double get_max<double>() {
 }
 #endif
 
+///
+/// @brief interleaves the lowest @p bits bits of each coordinate of @p x into
+/// a single key, most significant bits first
+///
+template <unsigned int D>
+CUDA_HOST_DEVICE uint64_t interleave_bits(const Vector<unsigned int, D> &x,
+                                          const unsigned int bits) {
+  uint64_t key = 0;
+  for (int b = bits - 1; b >= 0; --b) {
+    for (size_t i = 0; i < D; ++i) {
+      key = (key << 1) | ((x[i] >> b) & 1u);
+    }
+  }
+  return key;
+}
+
+///
+/// @brief returns the position of the lattice point @p x along a Morton
+/// (Z-order) curve, using @p bits bits per dimension
+///
+template <unsigned int D>
+CUDA_HOST_DEVICE uint64_t morton_key(const Vector<unsigned int, D> &x,
+                                     const unsigned int bits) {
+  return interleave_bits(x, bits);
+}
+
+///
+/// @brief returns the position of the lattice point @p x along a Hilbert
+/// curve, using @p bits bits per dimension
+///
+/// Uses the "axes to transpose" algorithm from J. Skilling, "Programming the
+/// Hilbert curve", AIP Conf. Proc. 707, 381 (2004)
+///
+template <unsigned int D>
+CUDA_HOST_DEVICE uint64_t hilbert_key(Vector<unsigned int, D> x,
+                                      const unsigned int bits) {
+  const unsigned int M = 1u << (bits - 1);
+  // inverse undo
+  for (unsigned int Q = M; Q > 1; Q >>= 1) {
+    const unsigned int P = Q - 1;
+    for (size_t i = 0; i < D; ++i) {
+      if (x[i] & Q) {
+        x[0] ^= P;
+      } else {
+        const unsigned int t = (x[0] ^ x[i]) & P;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+  // gray encode
+  for (size_t i = 1; i < D; ++i) {
+    x[i] ^= x[i - 1];
+  }
+  unsigned int t = 0;
+  for (unsigned int Q = M; Q > 1; Q >>= 1) {
+    if (x[D - 1] & Q) {
+      t ^= Q - 1;
+    }
+  }
+  for (size_t i = 0; i < D; ++i) {
+    x[i] ^= t;
+  }
+  return interleave_bits(x, bits);
+}
+
 template <unsigned int D> struct bucket_index {
   typedef Vector<double, D> double_d;
   typedef Vector<unsigned int, D> unsigned_int_d;
@@ -39,11 +106,23 @@ template <unsigned int D> struct bucket_index {
 
   unsigned_int_d m_size;
 
+  ///
+  /// @brief optional map from the row-major index of each bucket to its
+  /// final index (e.g. its position along a space-filling curve). If null,
+  /// buckets are numbered in row-major order.
+  ///
+  /// Note that reassemble_index_vector() always inverts the row-major
+  /// numbering
+  ///
+  const unsigned int *m_index_map;
+
   CUDA_HOST_DEVICE
-  bucket_index(){};
+  bucket_index() : m_index_map(nullptr){};
 
   CUDA_HOST_DEVICE
-  bucket_index(const unsigned_int_d &size) : m_size(size) {}
+  bucket_index(const unsigned_int_d &size,
+               const unsigned int *index_map = nullptr)
+      : m_size(size), m_index_map(index_map) {}
 
   inline CUDA_HOST_DEVICE int collapse_index_vector(const int_d &vindex) const {
     int index = 0;
@@ -54,7 +133,7 @@ template <unsigned int D> struct bucket_index {
       }
       index += multiplier * vindex[i];
     }
-    return index;
+    return m_index_map ? m_index_map[index] : index;
   }
 
   inline CUDA_HOST_DEVICE unsigned int
@@ -67,7 +146,7 @@ template <unsigned int D> struct bucket_index {
       }
       index += multiplier * vindex[i];
     }
-    return index;
+    return m_index_map ? m_index_map[index] : index;
   }
 
   inline CUDA_HOST_DEVICE int_d reassemble_index_vector(const int index) const {
@@ -110,8 +189,10 @@ template <unsigned int D> struct point_to_bucket_index {
   CUDA_HOST_DEVICE
   point_to_bucket_index(const unsigned_int_d &size,
                         const double_d &bucket_side_length,
-                        const bbox<D> &bounds)
-      : m_bucket_index(size), m_bucket_side_length(bucket_side_length),
+                        const bbox<D> &bounds,
+                        const unsigned int *index_map = nullptr)
+      : m_bucket_index(size, index_map),
+        m_bucket_side_length(bucket_side_length),
         m_inv_bucket_side_length(1.0 / bucket_side_length), m_bounds(bounds) {}
 
   CUDA_HOST_DEVICE
@@ -192,10 +273,22 @@ inline CUDA_HOST_DEVICE int get_leaf_id(int offset) {
 
 inline CUDA_HOST_DEVICE int get_leaf_offset(int id) { return 0x80000000 ^ id; }
 
-inline CUDA_HOST_DEVICE int child_tag_mask(int tag, int which_child, int level,
-                                           int max_level, unsigned int D) {
+/// the type used for the morton tags of the HyperOctree. A tag stores D bits
+/// per tree level, so a 64-bit tag allows 63/D levels (21 levels in 3D)
+typedef uint64_t octree_tag_type;
+
+/// the maximum number of levels that fit in an octree_tag_type for dimension D
+/// (one bit is kept spare for the shift in point_to_tag)
+inline CUDA_HOST_DEVICE constexpr int octree_max_level(unsigned int D) {
+  return (8 * sizeof(octree_tag_type) - 1) / D;
+}
+
+inline CUDA_HOST_DEVICE octree_tag_type child_tag_mask(octree_tag_type tag,
+                                                       int which_child,
+                                                       int level, int max_level,
+                                                       unsigned int D) {
   int shift = (max_level - level) * D;
-  return tag | (which_child << shift);
+  return tag | (static_cast<octree_tag_type>(which_child) << shift);
 }
 
 template <int CODE> struct is_a {
@@ -206,11 +299,11 @@ template <int CODE> struct is_a {
 };
 
 template <unsigned int D>
-CUDA_HOST_DEVICE int point_to_tag(const Vector<double, D> &p, bbox<D> box,
-                                  int max_level) {
+CUDA_HOST_DEVICE octree_tag_type point_to_tag(const Vector<double, D> &p,
+                                              bbox<D> box, int max_level) {
   typedef Vector<double, D> double_d;
   typedef Vector<int, D> int_d;
-  int result = 0;
+  octree_tag_type result = 0;
 
   for (int level = 1; level <= max_level; ++level) {
     double_d mid;
@@ -238,7 +331,8 @@ CUDA_HOST_DEVICE int point_to_tag(const Vector<double, D> &p, bbox<D> box,
   return result;
 }
 
-template <unsigned int D> void print_tag(int tag, int max_level) {
+template <unsigned int D>
+void print_tag(octree_tag_type tag, int max_level) {
   for (int level = 1; level <= max_level; ++level) {
     std::bitset<D> bits = tag >> (max_level - level) * D;
     std::cout << bits << " ";
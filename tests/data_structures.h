@@ -392,6 +392,104 @@ public:
     TS_ASSERT_EQUALS(child_count_recurse, child_count_subtree);
   }
 
+  template <template <typename, typename> class Vector,
+            template <typename> class SearchMethod>
+  void helper_clustered_data_structure() {
+    // a tight cluster of particles needs many more levels than a uniform
+    // distribution to keep the number of particles in each leaf small
+    const size_t N = 1000;
+    const int n_particles_in_leaf = 10;
+    const double cluster_width = 1e-4;
+    typedef Particles<std::tuple<>, 3, Vector, SearchMethod> Particles_t;
+    typedef typename Particles_t::position position;
+    Particles_t particles(N);
+
+    std::uniform_real_distribution<double> uniform(0, 1);
+    for (size_t i = 0; i < N; ++i) {
+      auto &gen = get<generator>(particles)[i];
+      get<position>(particles)[i] =
+          vdouble3(0.3, 0.3, 0.3) +
+          cluster_width * vdouble3(uniform(gen), uniform(gen), uniform(gen));
+    }
+
+    particles.init_neighbour_search(vdouble3(0, 0, 0), vdouble3(1, 1, 1),
+                                    vdouble3(false, false, false),
+                                    n_particles_in_leaf);
+
+    auto query = particles.get_query();
+    TS_ASSERT_LESS_THAN(8, query.number_of_levels());
+
+    size_t num_particles_in_leaves = 0;
+    for (auto i = query.get_subtree(); i != false; ++i) {
+      if (query.is_leaf_node(*i)) {
+        int num_particles = 0;
+        for (auto j = query.get_bucket_particles(*i); j != false; ++j) {
+          num_particles++;
+        }
+        TS_ASSERT_LESS_THAN_EQUALS(num_particles, n_particles_in_leaf);
+        num_particles_in_leaves += num_particles;
+      }
+    }
+    TS_ASSERT_EQUALS(num_particles_in_leaves, N);
+
+    const double radius = 0.1 * cluster_width;
+    for (size_t i = 0; i < N; i += 50) {
+      const vdouble3 &pi = get<position>(particles)[i];
+      int count = 0;
+      for (auto j = euclidean_search(query, pi, radius); j != false; ++j) {
+        count++;
+      }
+      int brute_force_count = 0;
+      for (size_t j = 0; j < N; ++j) {
+        if ((get<position>(particles)[j] - pi).norm() < radius) {
+          brute_force_count++;
+        }
+      }
+      TS_ASSERT_EQUALS(count, brute_force_count);
+    }
+  }
+
+  template <template <typename> class SearchMethod>
+  void helper_reproducible_data_structure() {
+    // positions are snapped to a coarse grid so that there are many ties in
+    // each dimension, and N is large enough to use the parallel algorithms
+    const size_t N = 10000;
+    typedef Particles<std::tuple<>, 3, std::vector, SearchMethod> Particles_t;
+    typedef typename Particles_t::position position;
+    Particles_t particles(N);
+    Particles_t particles_serial(N);
+
+    std::default_random_engine gen;
+    std::uniform_int_distribution<int> uniform(0, 99);
+    for (size_t i = 0; i < N; ++i) {
+      const vdouble3 p =
+          0.01 * vdouble3(uniform(gen), uniform(gen), uniform(gen)) + 0.005;
+      get<position>(particles)[i] = p;
+      get<position>(particles_serial)[i] = p;
+    }
+
+    particles.init_neighbour_search(vdouble3(0, 0, 0), vdouble3(1, 1, 1),
+                                    vdouble3(false, false, false), 10);
+#ifdef HAVE_OPENMP
+    const int nthreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+    particles_serial.init_neighbour_search(
+        vdouble3(0, 0, 0), vdouble3(1, 1, 1), vdouble3(false, false, false),
+        10);
+#ifdef HAVE_OPENMP
+    omp_set_num_threads(nthreads);
+#endif
+
+    TS_ASSERT_EQUALS(particles.get_query().number_of_buckets(),
+                     particles_serial.get_query().number_of_buckets());
+    TS_ASSERT_EQUALS(particles.get_query().number_of_levels(),
+                     particles_serial.get_query().number_of_levels());
+    for (size_t i = 0; i < N; ++i) {
+      TS_ASSERT_EQUALS(get<id>(particles)[i], get<id>(particles_serial)[i]);
+    }
+  }
+
   template <template <typename> class SearchMethod> void draw_data_structure() {
     using Particles_t = Particles<std::tuple<>, 2, std::vector, SearchMethod>;
     Particles_t particles(500);
@@ -498,10 +596,18 @@ public:
     std::cout << "Octtree" << std::endl;
     helper_data_structure<std::vector, HyperOctree>();
   }
+  void test_HyperOctree_clustered() {
+    std::cout << "Octtree clustered" << std::endl;
+    helper_clustered_data_structure<std::vector, HyperOctree>();
+  }
   void test_kdtree() {
     std::cout << "kd tree" << std::endl;
     helper_data_structure<std::vector, Kdtree>();
   }
+  void test_kdtree_reproducible() {
+    std::cout << "kd tree reproducible" << std::endl;
+    helper_reproducible_data_structure<Kdtree>();
+  }
 };
 
 #endif /* SPATIAL_DATA_STRUCTURES_H_ */
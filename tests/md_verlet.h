@@ -60,7 +60,6 @@ using namespace Aboria;
 class MDLevel1Test : public CxxTest::TestSuite {
 public:
   ABORIA_VARIABLE(velocity, vdouble2, "velocity")
-  ABORIA_VARIABLE(verlet, std::vector<int>, "verlet-list")
 
   template <template <typename, typename> class Vector,
             template <typename> class SearchMethod>
@@ -74,7 +73,7 @@ public:
      * "velocity", represented by a 2d double vector
      */
     //<-
-    typedef Particles<std::tuple<velocity, verlet>, 2, Vector, SearchMethod>
+    typedef Particles<std::tuple<velocity>, 2, Vector, SearchMethod>
         container_type;
     //->
     //=        typedef Particles<std::tuple<velocity>,2> container_type;
@@ -136,49 +135,42 @@ public:
     particles.init_neighbour_search(vdouble2(0, 0), vdouble2(L, L),
                                     vbool2(true, true));
 
+    /*
+     * create a verlet list with a skin distance of buffer. This is only
+     * rebuilt once a particle has moved more than half the skin distance
+     */
+    VerletList<query_type> verlet_list(diameter, buffer);
+
     /*
      * perform MD timestepping
      */
-    for (int i = 0; i < timesteps / n_reuse_verlet_list; ++i) {
-      // build verlet list
-      for (auto i : particles) {
-        std::vector<int> &verlet_list = get<verlet>(i);
-        verlet_list.clear();
-        for (auto j = euclidean_search(particles.get_query(), get<position>(i),
-                                       diameter + buffer);
-             j != false; ++j) {
-          // hack to get index: look at id pointers
-          const int j_index = &get<id>(*j) - &get<id>(particles[0]);
-          verlet_list.push_back(j_index);
-        }
-      }
-      // timesteps
-      for (int vi = 0; vi < n_reuse_verlet_list; ++vi) {
-        for (auto i : particles) {
-          vdouble2 force_sum(0, 0);
-          for (int j_index : get<verlet>(i)) {
-            const_reference j = particles[j_index];
-            const vdouble2 dx = particles.correct_dx_for_periodicity(
-                get<position>(j) - get<position>(i));
-            const double r2 = dx.squaredNorm();
-            if (r2 > 0 && r2 < diameter2) {
-              force_sum -= k * (diameter / std::sqrt(r2) - 1) * dx;
-            }
-          }
-          get<velocity>(i) += dt * force_sum / mass;
-          const double v2 = get<velocity>(i).squaredNorm();
-          if (v2 > max_velocity2) {
-            get<velocity>(i) *= max_velocity / std::sqrt(v2);
+    for (int ts = 0; ts < timesteps; ++ts) {
+      verlet_list.update(particles.get_query());
+      for (size_t i = 0; i < particles.size(); ++i) {
+        reference pi = particles[i];
+        vdouble2 force_sum(0, 0);
+        for (int j_index : verlet_list.get_neighbours(i)) {
+          const_reference pj = particles[j_index];
+          const vdouble2 dx = particles.correct_dx_for_periodicity(
+              get<position>(pj) - get<position>(pi));
+          const double r2 = dx.squaredNorm();
+          if (r2 < diameter2) {
+            force_sum -= k * (diameter / std::sqrt(r2) - 1) * dx;
           }
         }
-        for (auto i : particles) {
-          get<position>(i) += dt * get<velocity>(i);
+        get<velocity>(pi) += dt * force_sum / mass;
+        const double v2 = get<velocity>(pi).squaredNorm();
+        if (v2 > max_velocity2) {
+          get<velocity>(pi) *= max_velocity / std::sqrt(v2);
         }
-        std::cout << "." << std::flush;
+      }
+      for (auto i : particles) {
+        get<position>(i) += dt * get<velocity>(i);
+      }
+      std::cout << "." << std::flush;
 #ifdef HAVE_VTK
-        vtkWriteGrid("particles", io, particles.get_grid(true));
+      vtkWriteGrid("particles", io, particles.get_grid(true));
 #endif
-      }
       particles.update_positions();
     }
   }
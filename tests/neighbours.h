@@ -1087,6 +1087,218 @@ public:
     }
   }
 
+  template <unsigned int D, template <typename, typename> class VectorType,
+            template <typename> class SearchMethod>
+  void helper_verlet_list(const int N, const double cutoff, const double skin,
+                          const bool is_periodic) {
+    typedef Vector<double, D> double_d;
+    typedef Vector<bool, D> bool_d;
+    typedef Particles<std::tuple<>, D, VectorType, SearchMethod>
+        particles_type;
+    typedef typename particles_type::position position;
+    typedef typename particles_type::query_type query_type;
+
+    particles_type particles(N);
+    std::default_random_engine gen;
+    std::uniform_real_distribution<double> uniform(0, 1);
+    for (int i = 0; i < N; ++i) {
+      for (size_t d = 0; d < D; ++d) {
+        get<position>(particles)[i][d] = uniform(gen);
+      }
+    }
+    particles.init_neighbour_search(double_d::Constant(0),
+                                    double_d::Constant(1),
+                                    bool_d::Constant(is_periodic));
+
+    VerletList<query_type> verlet(cutoff, skin);
+    TS_ASSERT(verlet.update(particles.get_query()));
+    TS_ASSERT_EQUALS(verlet.size(), N);
+
+    auto check_list = [&]() {
+      for (int i = 0; i < N; ++i) {
+        const double_d &pi = get<position>(particles)[i];
+        // all particles within cutoff must be in the list
+        int count_brute = 0;
+        for (int j = 0; j < N; ++j) {
+          const double_d dx = particles.correct_dx_for_periodicity(
+              get<position>(particles)[j] - pi);
+          if (i != j && dx.squaredNorm() < std::pow(cutoff, 2)) {
+            ++count_brute;
+          }
+        }
+        int count_list = 0;
+        for (const int j : verlet.get_neighbours(i)) {
+          TS_ASSERT_DIFFERS(i, j);
+          const double_d dx = particles.correct_dx_for_periodicity(
+              get<position>(particles)[j] - pi);
+          if (dx.squaredNorm() < std::pow(cutoff, 2)) {
+            ++count_list;
+          }
+        }
+        TS_ASSERT_EQUALS(count_list, count_brute);
+      }
+    };
+    check_list();
+
+    // small displacements do not trigger a rebuild, but the list is still
+    // valid
+    std::uniform_real_distribution<double> small_step(-0.2 * skin / std::sqrt(D),
+                                                      0.2 * skin / std::sqrt(D));
+    for (int i = 0; i < N; ++i) {
+      for (size_t d = 0; d < D; ++d) {
+        double &x = get<position>(particles)[i][d];
+        x += small_step(gen);
+        if (!is_periodic) {
+          x = std::min(std::max(x, 0.0), 0.999);
+        }
+      }
+    }
+    particles.update_positions();
+    TS_ASSERT(!verlet.update(particles.get_query()));
+    check_list();
+
+    // large displacements trigger a rebuild
+    get<position>(particles)[0] = double_d::Constant(0.5);
+    get<position>(particles)[N - 1] = double_d::Constant(0.25);
+    particles.update_positions();
+    TS_ASSERT(verlet.update(particles.get_query()));
+    check_list();
+  }
+
+  template <unsigned int D, template <typename, typename> class VectorType,
+            template <typename> class SearchMethod>
+  void helper_knn_search(const int N, const size_t k, const bool is_periodic) {
+    typedef Vector<double, D> double_d;
+    typedef Vector<bool, D> bool_d;
+    typedef Particles<std::tuple<>, D, VectorType, SearchMethod>
+        particles_type;
+    typedef typename particles_type::position position;
+
+    particles_type particles(N);
+    std::default_random_engine gen;
+    std::uniform_real_distribution<double> uniform(0, 1);
+    for (int i = 0; i < N; ++i) {
+      for (size_t d = 0; d < D; ++d) {
+        get<position>(particles)[i][d] = uniform(gen);
+      }
+    }
+    particles.init_neighbour_search(double_d::Constant(0),
+                                    double_d::Constant(1),
+                                    bool_d::Constant(is_periodic), 10);
+
+    // brute force k nearest neighbours
+    auto brute_force = [&](const double_d &centre) {
+      std::vector<std::pair<double, int>> result(N);
+      for (int j = 0; j < N; ++j) {
+        const double_d dx = particles.correct_dx_for_periodicity(
+            get<position>(particles)[j] - centre);
+        result[j] = std::make_pair(dx.norm(), j);
+      }
+      std::sort(result.begin(), result.end());
+      result.resize(std::min(k, result.size()));
+      return result;
+    };
+
+    const int n_points = 50;
+    std::vector<double_d> points(n_points);
+    for (int i = 0; i < n_points; ++i) {
+      for (size_t d = 0; d < D; ++d) {
+        // include points outside the domain
+        points[i][d] = 1.2 * uniform(gen) - 0.1;
+      }
+    }
+
+    for (const double_d &centre : points) {
+      const auto expected = brute_force(centre);
+      const auto result = knn_search(particles.get_query(), centre, k);
+      TS_ASSERT_EQUALS(result.size(), expected.size());
+      for (size_t j = 0; j < result.size(); ++j) {
+        TS_ASSERT_EQUALS(result[j].second, expected[j].second);
+        TS_ASSERT_DELTA(result[j].first, expected[j].first, 1e-10);
+      }
+    }
+
+    // batched search
+    std::vector<int> indices;
+    std::vector<double> distances;
+    knn_search(particles.get_query(), points.begin(), points.end(), k,
+               indices, distances);
+    TS_ASSERT_EQUALS(indices.size(), n_points * k);
+    TS_ASSERT_EQUALS(distances.size(), n_points * k);
+    for (int i = 0; i < n_points; ++i) {
+      const auto expected = brute_force(points[i]);
+      for (size_t j = 0; j < k; ++j) {
+        if (j < expected.size()) {
+          TS_ASSERT_EQUALS(indices[i * k + j], expected[j].second);
+          TS_ASSERT_DELTA(distances[i * k + j], expected[j].first, 1e-10);
+        } else {
+          TS_ASSERT_EQUALS(indices[i * k + j], -1);
+        }
+      }
+    }
+  }
+
+  template <unsigned int D>
+  void helper_cell_ordering(const int N, const double r,
+                            const bool is_periodic,
+                            const cell_ordering ordering) {
+    typedef Vector<double, D> double_d;
+    typedef Vector<bool, D> bool_d;
+    typedef Particles<std::tuple<>, D, std::vector, CellListOrdered>
+        particles_type;
+    typedef typename particles_type::position position;
+
+    particles_type particles(N);
+    std::default_random_engine gen;
+    std::uniform_real_distribution<double> uniform(-1, 1);
+    for (int i = 0; i < N; ++i) {
+      for (size_t d = 0; d < D; ++d) {
+        get<position>(particles)[i][d] = uniform(gen);
+      }
+    }
+    particles.get_neighbour_search().set_cell_ordering(ordering);
+    particles.init_neighbour_search(double_d::Constant(-1),
+                                    double_d::Constant(1),
+                                    bool_d::Constant(is_periodic), 5);
+    const auto &query = particles.get_query();
+
+    // buckets are numbered 0 to number_of_buckets()-1
+    std::vector<int> bucket_count(query.number_of_buckets(), 0);
+    for (auto i = query.get_subtree(); i != false; ++i) {
+      ++bucket_count[query.get_bucket_index(*i)];
+    }
+    for (size_t i = 0; i < bucket_count.size(); ++i) {
+      TS_ASSERT_EQUALS(bucket_count[i], 1);
+    }
+
+    // particles are sorted by bucket number
+    for (int i = 1; i < N; ++i) {
+      TS_ASSERT_LESS_THAN_EQUALS(
+          query.get_bucket_index(
+              *query.get_bucket(get<position>(particles)[i - 1])),
+          query.get_bucket_index(
+              *query.get_bucket(get<position>(particles)[i])));
+    }
+
+    // neighbour search matches brute force
+    for (int i = 0; i < N; ++i) {
+      const double_d &pi = get<position>(particles)[i];
+      int count_brute = 0;
+      for (int j = 0; j < N; ++j) {
+        const double_d dx = particles.correct_dx_for_periodicity(
+            get<position>(particles)[j] - pi);
+        if (dx.norm() < r) {
+          ++count_brute;
+        }
+      }
+      int count_search = 0;
+      for (auto j = euclidean_search(query, pi, r); j != false; ++j) {
+        ++count_search;
+      }
+      TS_ASSERT_EQUALS(count_search, count_brute);
+    }
+  }
+
   void test_std_vector_CellList(void) {
     helper_d_test_list_random<std::vector, CellList>();
     helper_single_particle<std::vector, CellList>();
@@ -1102,6 +1314,13 @@ public:
     helper_d_test_list_regular<std::vector, CellListOrdered>();
   }
 
+  void test_std_vector_CellListOrdered_cell_ordering(void) {
+    helper_cell_ordering<2>(1000, 0.1, false, cell_ordering::morton);
+    helper_cell_ordering<2>(1000, 0.1, true, cell_ordering::hilbert);
+    helper_cell_ordering<3>(1000, 0.2, true, cell_ordering::morton);
+    helper_cell_ordering<3>(1000, 0.2, false, cell_ordering::hilbert);
+  }
+
   void test_std_vector_CellList_fast_bucketsearch(void) {
     helper_d_test_list_random_fast_bucketsearch<std::vector, CellList>();
     helper_single_particle<std::vector, CellList>();
@@ -1133,6 +1352,31 @@ public:
     helper_d_test_list_regular<std::vector, HyperOctree>();
   }
 
+  void test_verlet_list(void) {
+    helper_verlet_list<2, std::vector, CellList>(1000, 0.05, 0.01, true);
+    helper_verlet_list<2, std::vector, CellListOrdered>(1000, 0.05, 0.01,
+                                                        false);
+    helper_verlet_list<3, std::vector, Kdtree>(1000, 0.1, 0.02, false);
+    helper_verlet_list<3, std::vector, HyperOctree>(1000, 0.1, 0.02, true);
+  }
+
+  void test_knn_search(void) {
+    helper_knn_search<2, std::vector, CellList>(1000, 10, false);
+    helper_knn_search<2, std::vector, CellList>(1000, 10, true);
+    helper_knn_search<3, std::vector, CellListOrdered>(1000, 10, false);
+    helper_knn_search<2, std::vector, CellListOrdered>(1000, 10, true);
+    helper_knn_search<2, std::vector, Kdtree>(1000, 10, false);
+    helper_knn_search<3, std::vector, Kdtree>(1000, 10, true);
+    helper_knn_search<3, std::vector, HyperOctree>(1000, 10, false);
+    helper_knn_search<2, std::vector, HyperOctree>(1000, 10, true);
+#if not defined(__CUDACC__)
+    helper_knn_search<2, std::vector, KdtreeNanoflann>(1000, 10, false);
+#endif
+    // fewer particles than k
+    helper_knn_search<2, std::vector, CellList>(5, 10, true);
+    helper_knn_search<2, std::vector, Kdtree>(5, 10, false);
+  }
+
   // void test_thrust_vector_CellList(void) {
   //#if //defined(HAVE_THRUST)
   //    helper_d_test_list_regular<thrust::device_vector,CellList>();
@@ -807,6 +807,80 @@ the result in `m`.
 #endif // HAVE_EIGEN
   }
 
+  void test_dense_position_operator(void) {
+#ifdef HAVE_EIGEN
+    typedef Particles<std::tuple<>, 3> ParticlesType;
+    typedef position_d<3> position;
+    // not a multiple of the tile sizes used by KernelDense
+    const size_t n = 1001;
+    ParticlesType particles(n);
+
+    std::default_random_engine gen;
+    std::uniform_real_distribution<double> uniform(0, 1);
+    for (size_t i = 0; i < n; ++i) {
+      get<position>(particles)[i] =
+          vdouble3(uniform(gen), uniform(gen), uniform(gen));
+    }
+
+    auto position_kernel = [](const vdouble3 &a, const vdouble3 &b) {
+      return std::exp(-(b - a).squaredNorm());
+    };
+    auto kernel = [&](ParticlesType::const_reference a,
+                      ParticlesType::const_reference b) {
+      return position_kernel(get<position>(a), get<position>(b));
+    };
+    auto block_position_kernel = [](const vdouble3 &a, const vdouble3 &b) {
+      const vdouble3 dx = b - a;
+      Eigen::Matrix2d block;
+      block << std::exp(-dx.squaredNorm()), dx[0], dx[1],
+          1.0 / (1.0 + dx.squaredNorm());
+      return block;
+    };
+    auto block_kernel = [&](ParticlesType::const_reference a,
+                            ParticlesType::const_reference b) {
+      return block_position_kernel(get<position>(a), get<position>(b));
+    };
+
+    auto A = create_dense_operator(particles, particles, kernel);
+    auto A_position = create_dense_operator(particles, particles,
+                                            position_kernel);
+    auto B = create_dense_operator(particles, particles, block_kernel);
+    auto B_position = create_dense_operator(particles, particles,
+                                            block_position_kernel);
+
+    Eigen::VectorXd x = Eigen::VectorXd::Random(n);
+    Eigen::VectorXd y = A * x;
+    Eigen::VectorXd y_position = A_position * x;
+    for (size_t i = 0; i < n; ++i) {
+      TS_ASSERT_DELTA(y[i], y_position[i], 1e-10);
+    }
+
+    Eigen::VectorXd x2 = Eigen::VectorXd::Random(2 * n);
+    Eigen::VectorXd y2 = B * x2;
+    Eigen::VectorXd y2_position = B_position * x2;
+    for (size_t i = 0; i < 2 * n; ++i) {
+      TS_ASSERT_DELTA(y2[i], y2_position[i], 1e-10);
+    }
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(n, 3);
+    Eigen::MatrixXd Y = A * X;
+    Eigen::MatrixXd Y_position = A_position * X;
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t k = 0; k < 3; ++k) {
+        TS_ASSERT_DELTA(Y(i, k), Y_position(i, k), 1e-10);
+      }
+    }
+
+    // compare against the assembled matrix
+    Eigen::MatrixXd A_copy(n, n);
+    A_position.assemble(A_copy);
+    Eigen::VectorXd y_copy = A_copy * x;
+    for (size_t i = 0; i < n; ++i) {
+      TS_ASSERT_DELTA(y_copy[i], y_position[i], 1e-10);
+    }
+#endif // HAVE_EIGEN
+  }
+
   void test_sparse_operator(void) {
 #ifdef HAVE_EIGEN
     ABORIA_VARIABLE(scalar1, double, "scalar1")
@@ -966,6 +1040,206 @@ the result in `m`.
 #endif // HAVE_EIGEN
   }
 
+  void test_sparse_assembly(void) {
+#ifdef HAVE_EIGEN
+    ABORIA_VARIABLE(scalar, double, "scalar")
+
+    typedef Particles<std::tuple<scalar>, 2> ParticlesType;
+    typedef position_d<2> position;
+    const size_t n = 200;
+    ParticlesType particles(n);
+
+    std::default_random_engine gen;
+    std::uniform_real_distribution<double> uniform(0, 1);
+    for (size_t i = 0; i < n; ++i) {
+      get<position>(particles)[i] = vdouble2(uniform(gen), uniform(gen));
+      get<scalar>(particles)[i] = uniform(gen);
+    }
+    particles.init_neighbour_search(vdouble2::Constant(0),
+                                    vdouble2::Constant(1),
+                                    vbool2::Constant(false), 10);
+
+    auto dense_kernel = [](ParticlesType::const_reference a,
+                           ParticlesType::const_reference b) {
+      return get<scalar>(a) - get<scalar>(b);
+    };
+    auto sparse_kernel = [](const vdouble2 &dx,
+                            ParticlesType::const_reference a,
+                            ParticlesType::const_reference b) {
+      return get<scalar>(a) * get<scalar>(b) + dx.norm();
+    };
+
+    auto Dense = create_dense_operator(particles, particles, dense_kernel);
+    auto Sparse =
+        create_sparse_operator(particles, particles, 0.1, sparse_kernel);
+    auto Cached =
+        create_sparse_operator(particles, particles, 0.2, sparse_kernel);
+    Cached.get_first_kernel().enable_cache();
+    auto Zero = create_zero_operator(particles, particles);
+    auto A = create_block_operator<2, 2>(Sparse, Zero, Dense, Cached);
+
+    Eigen::MatrixXd A_dense(2 * n, 2 * n);
+    A.assemble(A_dense);
+
+    Eigen::SparseMatrix<double> A_col_major(2 * n, 2 * n);
+    A.assemble(A_col_major);
+    Eigen::SparseMatrix<double, Eigen::RowMajor> A_row_major(2 * n, 2 * n);
+    A.assemble(A_row_major);
+
+    std::vector<Eigen::Triplet<double>> triplets;
+    A.assemble(triplets);
+    Eigen::SparseMatrix<double> A_triplets(2 * n, 2 * n);
+    A_triplets.setFromTriplets(triplets.begin(), triplets.end());
+
+    TS_ASSERT(A_row_major.isCompressed());
+    TS_ASSERT_EQUALS(A_row_major.nonZeros(), A_col_major.nonZeros());
+    TS_ASSERT_EQUALS(static_cast<size_t>(A_row_major.nonZeros()),
+                     triplets.size());
+    for (size_t i = 0; i < 2 * n; ++i) {
+      for (size_t j = 0; j < 2 * n; ++j) {
+        TS_ASSERT_EQUALS(A_dense(i, j), A_row_major.coeff(i, j));
+        TS_ASSERT_EQUALS(A_dense(i, j), A_col_major.coeff(i, j));
+        TS_ASSERT_EQUALS(A_dense(i, j), A_triplets.coeff(i, j));
+      }
+    }
+
+    // compare against the matrix-free product
+    Eigen::VectorXd x = Eigen::VectorXd::Random(2 * n);
+    Eigen::VectorXd y = A * x;
+    Eigen::VectorXd y_sparse = A_row_major * x;
+    for (size_t i = 0; i < 2 * n; ++i) {
+      TS_ASSERT_DELTA(y[i], y_sparse[i], 1e-10);
+    }
+#endif // HAVE_EIGEN
+  }
+
+  void test_sparse_operator_cached(void) {
+#ifdef HAVE_EIGEN
+    ABORIA_VARIABLE(scalar, double, "scalar")
+
+    typedef Particles<std::tuple<scalar>> ParticlesType;
+    typedef position_d<3> position;
+    const size_t n = 200;
+    ParticlesType particles(n);
+
+    const double radius = 0.3;
+    std::default_random_engine gen;
+    std::uniform_real_distribution<double> uniform(0, 1);
+    for (size_t i = 0; i < n; ++i) {
+      get<position>(particles)[i] =
+          vdouble3(uniform(gen), uniform(gen), uniform(gen));
+      get<scalar>(particles)[i] = uniform(gen);
+    }
+    particles.init_neighbour_search(vdouble3::Constant(0),
+                                    vdouble3::Constant(1),
+                                    vbool3::Constant(true));
+
+    auto kernel = [](const position::value_type &dx,
+                     ParticlesType::const_reference a,
+                     ParticlesType::const_reference b) {
+      return get<scalar>(a) * get<scalar>(b) / (dx.norm() + 0.1);
+    };
+    auto C = create_sparse_operator(particles, particles, radius, kernel);
+    auto C_cached = create_sparse_operator(particles, particles, radius, kernel);
+    auto C_cached_values =
+        create_sparse_operator(particles, particles, radius, kernel);
+    C_cached.get_first_kernel().enable_cache();
+    C_cached_values.get_first_kernel().enable_cache(true);
+
+    Eigen::VectorXd v = Eigen::VectorXd::Random(n);
+    for (int step = 0; step < 2; ++step) {
+      Eigen::VectorXd ans = C * v;
+      for (int repeat = 0; repeat < 2; ++repeat) {
+        Eigen::VectorXd ans_cached = C_cached * v;
+        Eigen::VectorXd ans_cached_values = C_cached_values * v;
+        for (size_t i = 0; i < n; ++i) {
+          TS_ASSERT_DELTA(ans[i], ans_cached[i], 1e-10);
+          TS_ASSERT_DELTA(ans[i], ans_cached_values[i], 1e-10);
+        }
+      }
+      TS_ASSERT_LESS_THAN(n, C_cached.get_first_kernel().cache_size());
+      TS_ASSERT_EQUALS(C_cached.get_first_kernel().cache_size(),
+                       C_cached_values.get_first_kernel().cache_size());
+
+      // move the particles, the caches should be rebuilt
+      for (size_t i = 0; i < n; ++i) {
+        get<position>(particles)[i] =
+            vdouble3(uniform(gen), uniform(gen), uniform(gen));
+      }
+      particles.update_positions();
+    }
+#endif // HAVE_EIGEN
+  }
+
+  void test_multiple_rhs(void) {
+#ifdef HAVE_EIGEN
+    ABORIA_VARIABLE(scalar, double, "scalar")
+
+    typedef Particles<std::tuple<scalar>, 2> ParticlesType;
+    typedef position_d<2> position;
+    const size_t n = 100;
+    const size_t nrhs = 3;
+    ParticlesType particles(n);
+
+    std::default_random_engine gen;
+    std::uniform_real_distribution<double> uniform(0, 1);
+    for (size_t i = 0; i < n; ++i) {
+      get<position>(particles)[i] = vdouble2(uniform(gen), uniform(gen));
+      get<scalar>(particles)[i] = uniform(gen);
+    }
+    particles.init_neighbour_search(vdouble2::Constant(0),
+                                    vdouble2::Constant(1),
+                                    vbool2::Constant(false), 10);
+
+    auto position_kernel = [](const vdouble2 &a, const vdouble2 &b) {
+      return std::exp(-(b - a).squaredNorm());
+    };
+    auto kernel = [&](ParticlesType::const_reference a,
+                      ParticlesType::const_reference b) {
+      return position_kernel(get<position>(a), get<position>(b));
+    };
+    auto sparse_kernel = [](const vdouble2 &dx,
+                            ParticlesType::const_reference a,
+                            ParticlesType::const_reference b) {
+      return get<scalar>(a) * get<scalar>(b) * std::exp(-dx.squaredNorm());
+    };
+
+    auto Dense = create_dense_operator(particles, particles, kernel);
+    auto Matrix = create_matrix_operator(particles, particles, kernel);
+    auto Sparse = create_sparse_operator(particles, particles, 0.3,
+                                         sparse_kernel);
+    auto Cheb = create_chebyshev_operator(particles, particles, 6,
+                                          position_kernel);
+    auto FMM = create_fmm_operator<4>(particles, particles, position_kernel,
+                                      kernel);
+    auto Block = create_block_operator<2, 2>(Dense, Sparse, Sparse, Matrix);
+
+    Eigen::MatrixXd X = Eigen::MatrixXd::Random(n, nrhs);
+    Eigen::MatrixXd X2 = Eigen::MatrixXd::Random(2 * n, nrhs);
+
+    auto check_columns = [&](const auto &A, const Eigen::MatrixXd &X) {
+      Eigen::MatrixXd Y = A * X;
+      TS_ASSERT_EQUALS(static_cast<size_t>(Y.cols()), nrhs);
+      for (size_t k = 0; k < nrhs; ++k) {
+        Eigen::VectorXd x = X.col(k);
+        Eigen::VectorXd y = A * x;
+        for (size_t i = 0; i < static_cast<size_t>(y.size()); ++i) {
+          TS_ASSERT_DELTA(Y(i, k), y[i], 1e-10);
+        }
+      }
+    };
+
+    check_columns(Dense, X);
+    check_columns(Matrix, X);
+    check_columns(Sparse, X);
+    check_columns(Cheb, X);
+    check_columns(FMM, X);
+    check_columns(Block, X2);
+    Sparse.get_first_kernel().enable_cache();
+    check_columns(Sparse, X);
+#endif // HAVE_EIGEN
+  }
+
   void test_block_operator(void) {
 #ifdef HAVE_EIGEN
     ABORIA_VARIABLE(scalar1, double, "scalar1")
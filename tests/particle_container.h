@@ -113,6 +113,83 @@ public:
     TS_ASSERT_EQUALS(get<id>(p_value), 101);
   }
 
+  template <template <typename, typename> class V,
+            template <typename> class SearchMethod>
+  void helper_append_particles(void) {
+    ABORIA_VARIABLE(scalar, double, "scalar")
+    typedef std::tuple<scalar> variables_type;
+    typedef Particles<variables_type, 3, V, SearchMethod> Test_type;
+    typedef typename Test_type::position position;
+    typedef typename Test_type::value_type value_type;
+    Test_type test;
+    test.init_neighbour_search(vdouble3::Constant(0), vdouble3::Constant(1),
+                               vdouble3::Constant(false));
+
+    value_type p;
+    get<position>(p) = vdouble3::Constant(0.5);
+    get<scalar>(p) = -1;
+    test.push_back(p);
+
+    const size_t n = 1000;
+    std::default_random_engine gen;
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::vector<value_type> batch(n);
+    for (size_t i = 0; i < n; ++i) {
+      get<position>(batch[i]) =
+          vdouble3(uniform(gen), uniform(gen), uniform(gen));
+      get<scalar>(batch[i]) = i;
+    }
+    test.append(batch.begin(), batch.end());
+    TS_ASSERT_EQUALS(test.size(), n + 1);
+
+    // ids are unique and the scalar data has been copied across
+    std::vector<size_t> ids(test.size());
+    double sum = 0;
+    for (size_t i = 0; i < test.size(); ++i) {
+      ids[i] = get<id>(test[i]);
+      sum += get<scalar>(test[i]);
+      TS_ASSERT(get<alive>(test[i]));
+    }
+    std::sort(ids.begin(), ids.end());
+    for (size_t i = 0; i < ids.size(); ++i) {
+      TS_ASSERT_EQUALS(ids[i], i);
+    }
+    TS_ASSERT_EQUALS(sum, 0.5 * n * (n - 1) - 1);
+
+    // variables are still consistent after any reordering
+    for (size_t i = 0; i < test.size(); ++i) {
+      const int index = get<scalar>(test[i]);
+      if (index >= 0) {
+        TS_ASSERT((get<position>(test[i]) == get<position>(batch[index])).all());
+      }
+    }
+
+    // every particle can be found by the neighbour search
+    for (size_t i = 0; i < test.size(); ++i) {
+      int count = 0;
+      for (auto j = euclidean_search(test.get_query(), get<position>(test[i]),
+                                     1e-10);
+           j != false; ++j) {
+        ++count;
+      }
+      TS_ASSERT_EQUALS(count, 1);
+    }
+
+    // appending another container
+    Test_type test2;
+    test2.append(test.begin(), test.end());
+    TS_ASSERT_EQUALS(test2.size(), test.size());
+    test.push_back(test2);
+    TS_ASSERT_EQUALS(test.size(), 2 * (n + 1));
+
+    // inserting a range of value_type
+    test2.insert(test2.begin() + 1, batch.begin(), batch.begin() + 10);
+    TS_ASSERT_EQUALS(test2.size(), n + 11);
+    for (size_t i = 0; i < 10; ++i) {
+      TS_ASSERT_EQUALS(get<scalar>(test2[i + 1]), i);
+    }
+  }
+
   void test_documentation(void) {
 #if not defined(__CUDACC__)
     //[particle_container
@@ -442,6 +519,7 @@ public:
     helper_add_particle2<std::vector, CellList>();
     helper_add_particle2_dimensions<std::vector, CellList>();
     helper_add_delete_particle<std::vector, CellList>();
+    helper_append_particles<std::vector, CellList>();
   }
 
   void test_std_vector_CellListOrdered(void) {
@@ -449,6 +527,7 @@ public:
     helper_add_particle2<std::vector, CellListOrdered>();
     helper_add_particle2_dimensions<std::vector, CellListOrdered>();
     helper_add_delete_particle<std::vector, CellListOrdered>();
+    helper_append_particles<std::vector, CellListOrdered>();
   }
 
   void test_thrust_vector_CellListOrdered(void) {
@@ -457,6 +536,7 @@ public:
     helper_add_particle2<thrust::device_vector, CellListOrdered>();
     helper_add_particle2_dimensions<thrust::device_vector, CellListOrdered>();
     helper_add_delete_particle<thrust::device_vector, CellListOrdered>();
+    helper_append_particles<thrust::device_vector, CellListOrdered>();
 #endif
   }
 };
@@ -544,12 +544,64 @@ public:
     TS_ASSERT_EQUALS(result2, 2);
   }
 
+  void helper_random(void) {
+    ABORIA_VARIABLE(scalar1, double, "scalar1")
+    ABORIA_VARIABLE(scalar2, double, "scalar2")
+
+    typedef Particles<std::tuple<scalar1, scalar2>> ParticlesType;
+    ParticlesType particles(1000);
+    particles.set_seed(10);
+
+    Symbol<scalar1> s1;
+    Symbol<scalar2> s2;
+    Label<0, ParticlesType> a(particles);
+    Normal N;
+    Uniform U;
+
+    // multiple draws in one expression are independent
+    s1[a] = U[a];
+    s2[a] = U[a] - U[a];
+    double sum = 0;
+    int nzero = 0;
+    for (size_t i = 0; i < particles.size(); ++i) {
+      TS_ASSERT_LESS_THAN_EQUALS(0, get<scalar1>(particles)[i]);
+      TS_ASSERT_LESS_THAN(get<scalar1>(particles)[i], 1);
+      sum += get<scalar1>(particles)[i];
+      if (get<scalar2>(particles)[i] == 0) {
+        ++nzero;
+      }
+    }
+    TS_ASSERT_DELTA(sum / particles.size(), 0.5, 0.05);
+    TS_ASSERT_EQUALS(nzero, 0);
+
+    // subsequent assignments draw new numbers
+    const std::vector<double> first = get<scalar1>(particles);
+    s1[a] = N[a];
+    sum = 0;
+    for (size_t i = 0; i < particles.size(); ++i) {
+      TS_ASSERT_DIFFERS(get<scalar1>(particles)[i], first[i]);
+      sum += get<scalar1>(particles)[i];
+    }
+    TS_ASSERT_DELTA(sum / particles.size(), 0.0, 0.2);
+
+    // resetting the seed reproduces the same numbers
+    particles.set_seed(10);
+#ifdef ABORIA_COUNTER_BASED_RNG
+    particles.set_random_step(0);
+#endif
+    s1[a] = U[a];
+    for (size_t i = 0; i < particles.size(); ++i) {
+      TS_ASSERT_EQUALS(get<scalar1>(particles)[i], first[i]);
+    }
+  }
+
   void test_default() {
     helper_create_default_vectors();
     helper_create_double_vector();
     helper_transform();
     helper_neighbours();
     helper_level0_expressions();
+    helper_random();
   }
 };
 
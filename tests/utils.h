@@ -70,6 +70,51 @@ public:
     TS_ASSERT_EQUALS(vindex2[1], 2);
     TS_ASSERT_EQUALS(vindex2[2], 0);
     TS_ASSERT_EQUALS(vindex2[3], 4);
+
+    // space-filling curves: consecutive points along the Hilbert curve are
+    // neighbours on the lattice, and both curves visit every lattice point
+    // once
+    const unsigned int bits = 3;
+    const unsigned int n = 1 << bits;
+    std::vector<std::pair<uint64_t, vect>> hilbert, morton;
+    for (unsigned int i = 0; i < n; ++i) {
+      for (unsigned int j = 0; j < n; ++j) {
+        for (unsigned int k = 0; k < n; ++k) {
+          const vect x(i, j, k);
+          hilbert.push_back(std::make_pair(detail::hilbert_key(x, bits), x));
+          morton.push_back(std::make_pair(detail::morton_key(x, bits), x));
+        }
+      }
+    }
+    auto compare_keys = [](const std::pair<uint64_t, vect> &a,
+                           const std::pair<uint64_t, vect> &b) {
+      return a.first < b.first;
+    };
+    std::sort(hilbert.begin(), hilbert.end(), compare_keys);
+    std::sort(morton.begin(), morton.end(), compare_keys);
+    for (size_t i = 0; i < hilbert.size(); ++i) {
+      TS_ASSERT_EQUALS(hilbert[i].first, i);
+      TS_ASSERT_EQUALS(morton[i].first, i);
+      if (i > 0) {
+        const vint3 dx = hilbert[i].second.cast<int>() -
+                         hilbert[i - 1].second.cast<int>();
+        TS_ASSERT_EQUALS(dx.squaredNorm(), 1);
+      }
+    }
+    // morton key interleaves the bits of each coordinate
+    TS_ASSERT_EQUALS(detail::morton_key(vect(1, 0, 0), bits), 4);
+    TS_ASSERT_EQUALS(detail::morton_key(vect(0, 1, 0), bits), 2);
+    TS_ASSERT_EQUALS(detail::morton_key(vect(0, 0, 1), bits), 1);
+    TS_ASSERT_EQUALS(detail::morton_key(vect(2, 0, 0), bits), 32);
+
+    // buckets can be renumbered using an index map
+    std::vector<unsigned int> index_map(4 * 7 * 2);
+    for (size_t i = 0; i < index_map.size(); ++i) {
+      index_map[i] = index_map.size() - 1 - i;
+    }
+    detail::bucket_index<3> bi_map(vect(4, 7, 2), index_map.data());
+    TS_ASSERT_EQUALS(bi_map.collapse_index_vector(vect(1, 2, 1)),
+                     index_map.size() - 1 - 19);
   }
 
   void test_point_to_bucket_indicies(void) {
@@ -324,6 +369,117 @@ public:
 
 #endif
   }
+
+  void test_algorithms(void) {
+    // large enough to trigger the parallel algorithms (if enabled)
+    const size_t N = 10000;
+    std::vector<unsigned int> keys(N);
+    std::vector<int> data(N);
+    std::default_random_engine gen;
+    std::uniform_int_distribution<unsigned int> uniform(0, 100);
+    for (size_t i = 0; i < N; ++i) {
+      keys[i] = uniform(gen);
+      data[i] = i;
+    }
+
+    // sort_by_key
+    std::vector<unsigned int> sorted_keys = keys;
+    std::vector<int> sorted_data = data;
+    detail::sort_by_key(sorted_keys.begin(), sorted_keys.end(),
+                        sorted_data.begin());
+    TS_ASSERT(std::is_sorted(sorted_keys.begin(), sorted_keys.end()));
+    for (size_t i = 0; i < N; ++i) {
+      TS_ASSERT_EQUALS(keys[sorted_data[i]], sorted_keys[i]);
+      // integer keys use a radix sort, which is stable
+      if (i > 0 && sorted_keys[i - 1] == sorted_keys[i]) {
+        TS_ASSERT_LESS_THAN(sorted_data[i - 1], sorted_data[i]);
+      }
+    }
+
+    // sort_by_key with signed keys
+    std::vector<int> signed_keys(N);
+    std::uniform_int_distribution<int> uniform_signed(
+        std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+    for (size_t i = 0; i < N; ++i) {
+      signed_keys[i] = uniform_signed(gen);
+    }
+    std::vector<int> sorted_signed_keys = signed_keys;
+    std::vector<int> sorted_signed_data = data;
+    detail::sort_by_key(sorted_signed_keys.begin(), sorted_signed_keys.end(),
+                        sorted_signed_data.begin());
+    TS_ASSERT(
+        std::is_sorted(sorted_signed_keys.begin(), sorted_signed_keys.end()));
+    for (size_t i = 0; i < N; ++i) {
+      TS_ASSERT_EQUALS(signed_keys[sorted_signed_data[i]],
+                       sorted_signed_keys[i]);
+    }
+
+    // exclusive_scan
+    std::vector<int> scan(N);
+    detail::exclusive_scan(keys.begin(), keys.end(), scan.begin(), 0);
+    int sum = 0;
+    for (size_t i = 0; i < N; ++i) {
+      TS_ASSERT_EQUALS(scan[i], sum);
+      sum += keys[i];
+    }
+
+    // inclusive_scan
+    detail::inclusive_scan(keys.begin(), keys.end(), scan.begin());
+    sum = 0;
+    for (size_t i = 0; i < N; ++i) {
+      sum += keys[i];
+      TS_ASSERT_EQUALS(scan[i], sum);
+    }
+
+    // stable_partition
+    std::vector<unsigned int> partitioned = keys;
+    auto is_even = [](const unsigned int i) { return i % 2 == 0; };
+    auto ppoint = detail::stable_partition(partitioned.begin(),
+                                           partitioned.end(), is_even);
+    std::vector<unsigned int> std_partitioned = keys;
+    auto std_ppoint = std::stable_partition(std_partitioned.begin(),
+                                            std_partitioned.end(), is_even);
+    TS_ASSERT_EQUALS(ppoint - partitioned.begin(),
+                     std_ppoint - std_partitioned.begin());
+    TS_ASSERT(std::equal(partitioned.begin(), partitioned.end(),
+                         std_partitioned.begin()));
+
+    // copy_if
+    std::vector<int> copied(N);
+    auto copied_end = detail::copy_if(data.begin(), data.end(), keys.begin(),
+                                      copied.begin(), is_even);
+    TS_ASSERT_EQUALS(copied_end - copied.begin(),
+                     std_ppoint - std_partitioned.begin());
+    for (auto i = copied.begin(); i != copied_end; ++i) {
+      TS_ASSERT(is_even(keys[*i]));
+      if (i != copied.begin()) {
+        TS_ASSERT_LESS_THAN(*(i - 1), *i);
+      }
+    }
+
+    // gather
+    std::vector<unsigned int> gathered(N);
+    detail::gather(sorted_data.begin(), sorted_data.end(), keys.begin(),
+                   gathered.begin());
+    TS_ASSERT(std::equal(gathered.begin(), gathered.end(),
+                         sorted_keys.begin()));
+
+    // reduce
+    TS_ASSERT_EQUALS(
+        detail::reduce(keys.begin(), keys.end(), 0, std::plus<int>()), sum);
+
+    // exclusive_scan_by_key (segments are runs of equal sorted keys)
+    detail::exclusive_scan_by_key(sorted_keys.begin(), sorted_keys.end(),
+                                  keys.begin(), scan.begin(), 1);
+    sum = 1;
+    for (size_t i = 0; i < N; ++i) {
+      if (i > 0 && sorted_keys[i] != sorted_keys[i - 1]) {
+        sum = 1;
+      }
+      TS_ASSERT_EQUALS(scan[i], sum);
+      sum += keys[i];
+    }
+  }
 };
 
 #endif /* CONSTRUCTORS_H_ */